@@ -0,0 +1,65 @@
+#ifndef _DIR_MOESI_CACHE_H
+#define _DIR_MOESI_CACHE_H
+
+#include "../sim/types.h"
+#include "../sim/enums.h"
+#include "../sim/module.h"
+#include "../sim/mreq.h"
+#include "protocol_template.h"
+
+/**
+* This file contains the L1 side of the MOESI protocol for use with a directory
+* (see directory.h) instead of a snooping bus.
+*/
+
+/** Cache states.  */
+typedef enum {
+    DIR_MOESI_CACHE_I = 1,
+    DIR_MOESI_CACHE_S,
+    DIR_MOESI_CACHE_E,
+    DIR_MOESI_CACHE_O,
+    DIR_MOESI_CACHE_M,
+
+    //All the intermediate states added here
+    DIR_MOESI_CACHE_IS_Intermediate,
+    DIR_MOESI_CACHE_IM_Intermediate,
+    DIR_MOESI_CACHE_SM_Intermediate,
+    DIR_MOESI_CACHE_OM_Intermediate,
+    DIR_MOESI_CACHE_MI_Intermediate,
+    DIR_MOESI_CACHE_II_Intermediate,
+    DIR_MOESI_CACHE_NUM_STATES
+} DIR_MOESI_cache_state_t;
+
+class DIR_MOESI_protocol : public Protocol_template<DIR_MOESI_protocol> {
+public:
+    typedef DIR_MOESI_cache_state_t state_t;
+
+    DIR_MOESI_protocol (Hash_table *my_table, Hash_entry *my_entry);
+    ~DIR_MOESI_protocol ();
+
+    DIR_MOESI_cache_state_t state;
+    
+    /** Prints a state the way dump() does, for lines kept in a Cache_array */
+    static void dump_state (unsigned char state);
+
+    /** Makes a store to a line held in S or O send UPGRADE instead of GETM, which
+     * the directory grants without sending the data back.  Off by default.
+     * Rewrites the table, so call it before the simulation starts.
+     */
+    static void set_upgrade (bool upgrade);
+
+    /** State every line starts in */
+    static const state_t initial_state;
+
+    static const char *const name;
+    static const char *const state_names[DIR_MOESI_CACHE_NUM_STATES];
+    /** Dirty states, which supply data as the owner */
+    static const bool owner_states[DIR_MOESI_CACHE_NUM_STATES];
+
+    /** Actions and next state for each [state][message], see transition_table.h.
+     * Not const, set_upgrade patches the UPGRADE entries.
+     */
+    static Transition transitions[DIR_MOESI_CACHE_NUM_STATES][MREQ_MESSAGE_NUM];
+};
+
+#endif // _DIR_MOESI_CACHE_H
@@ -0,0 +1,205 @@
+#include "DIR_MSI_protocol.h"
+#include "../sim/mreq.h"
+#include "../sim/sim.h"
+#include "../sim/hash_table.h"
+
+extern Simulator *Sim;
+
+/**
+* This file contains the L1 side of the MSI protocol for use with a directory.
+* I, IS and IM acknowledge an INV as well, since an overflowed limited-pointer
+* directory broadcasts invalidations to every cache.
+*/
+
+/*************************
+ * Constructor/Destructor.
+ *************************/
+ 
+DIR_MSI_protocol::DIR_MSI_protocol (Hash_table *my_table, Hash_entry *my_entry)
+    : Protocol_template<DIR_MSI_protocol> (my_table, my_entry)
+{
+    // Initialize lines to not have the data yet!
+    this->state = initial_state;
+}
+
+DIR_MSI_protocol::~DIR_MSI_protocol ()
+{
+}
+
+const DIR_MSI_cache_state_t DIR_MSI_protocol::initial_state = DIR_MSI_CACHE_I;
+
+const char *const DIR_MSI_protocol::name = "DIR_MSI";
+
+/** Same size and order as the state enum in the header */
+const char *const DIR_MSI_protocol::state_names[DIR_MSI_CACHE_NUM_STATES] = {"X","I","S","M", "IS", "IM", "SM", "MI", "II"};
+
+/** Same order as state_names, true for the states that supply data as the
+ * line's owner (see supplier_of) rather than as a clean forwarder
+ */
+const bool DIR_MSI_protocol::owner_states[DIR_MSI_CACHE_NUM_STATES] = {
+    /* X */ false, /* I */ false, /* S */ false, /* M */ true, /* IS */ false,
+    /* IM */ false, /* SM */ false, /* MI */ true, /* II */ false
+};
+
+void DIR_MSI_protocol::dump_state (unsigned char state)
+{
+    fprintf (stderr, "DIR_MSI_protocol - state: %s\n", state_names[state]);
+}
+
+/** DIR_MSI transitions, indexed by [state][message].  Columns are in message_t order:
+ * NOP, LOAD, STORE, GETS, GETM, DATA, EVICT, PUTM, UPGRADE, UPDATE, DATA_EXCL,
+ * FWD_GETS, FWD_GETM, INV, INV_ACK, PUT_ACK.  GETS, GETM, PUTM and INV_ACK only go
+ * to the directory, so no cache sees them, UPGRADE only comes back as the grant
+ * and UPDATE belongs to the write-update protocols.
+ * Messages left out of a row are errors.
+ * The entries in upgrade_patches are shown with UPGRADE off, see set_upgrade
+ */
+Transition DIR_MSI_protocol::transitions[DIR_MSI_CACHE_NUM_STATES][MREQ_MESSAGE_NUM] = {
+    /* X */ TRANS_ROW_INVALID,
+    /* I */ {
+        TRANS_ERROR,
+        /* LOAD      */ TRANS (ACT_SEND_GETS | ACT_CACHE_MISS, DIR_MSI_CACHE_IS_Intermediate),
+        /* STORE     */ TRANS (ACT_SEND_GETM | ACT_CACHE_MISS, DIR_MSI_CACHE_IM_Intermediate),
+        /* GETS      */ TRANS_ERROR,
+        /* GETM      */ TRANS_ERROR,
+        /* DATA      */ TRANS_ERROR,
+        /* EVICT     */ TRANS (ACT_NONE, DIR_MSI_CACHE_I),
+        /* PUTM      */ TRANS_ERROR,
+        /* UPGRADE   */ TRANS_ERROR,
+        /* UPDATE    */ TRANS_ERROR,
+        /* DATA_EXCL */ TRANS_ERROR,
+        /* FWD_GETS  */ TRANS_ERROR,
+        /* FWD_GETM  */ TRANS_ERROR,
+        /* INV       */ TRANS (ACT_SEND_INV_ACK, DIR_MSI_CACHE_I)
+    },
+    /* S */ {
+        TRANS_ERROR,
+        /* LOAD      */ TRANS (ACT_SEND_DATA_PROC, DIR_MSI_CACHE_S),
+        /* STORE     */ TRANS (ACT_SEND_GETM | ACT_CACHE_MISS, DIR_MSI_CACHE_SM_Intermediate),
+        /* GETS      */ TRANS_ERROR,
+        /* GETM      */ TRANS_ERROR,
+        /* DATA      */ TRANS_ERROR,
+        /* EVICT     */ TRANS (ACT_NONE, DIR_MSI_CACHE_I),
+        /* PUTM      */ TRANS_ERROR,
+        /* UPGRADE   */ TRANS_ERROR,
+        /* UPDATE    */ TRANS_ERROR,
+        /* DATA_EXCL */ TRANS_ERROR,
+        /* FWD_GETS  */ TRANS_ERROR,
+        /* FWD_GETM  */ TRANS_ERROR,
+        /* INV       */ TRANS (ACT_SEND_INV_ACK, DIR_MSI_CACHE_I)
+    },
+    /* M */ {
+        TRANS_ERROR,
+        /* LOAD      */ TRANS (ACT_SEND_DATA_PROC, DIR_MSI_CACHE_M),
+        /* STORE     */ TRANS (ACT_SEND_DATA_PROC, DIR_MSI_CACHE_M),
+        /* GETS      */ TRANS_ERROR,
+        /* GETM      */ TRANS_ERROR,
+        /* DATA      */ TRANS_ERROR,
+        /* EVICT     */ TRANS (ACT_SEND_PUTM, DIR_MSI_CACHE_MI_Intermediate),
+        /* PUTM      */ TRANS_ERROR,
+        /* UPGRADE   */ TRANS_ERROR,
+        /* UPDATE    */ TRANS_ERROR,
+        /* DATA_EXCL */ TRANS_ERROR,
+        /* FWD_GETS  */ TRANS (ACT_SEND_DATA_BUS | ACT_SEND_DATA_DIR, DIR_MSI_CACHE_S),
+        /* FWD_GETM  */ TRANS (ACT_SEND_DATA_BUS | ACT_SEND_INV_ACK, DIR_MSI_CACHE_I)
+    },
+    /* IS */ {
+        TRANS_ERROR,
+        /* LOAD      */ TRANS (ACT_NONE, DIR_MSI_CACHE_IS_Intermediate),
+        /* STORE     */ TRANS (ACT_NONE, DIR_MSI_CACHE_IS_Intermediate),
+        /* GETS      */ TRANS_ERROR,
+        /* GETM      */ TRANS_ERROR,
+        /* DATA      */ TRANS (ACT_SEND_DATA_PROC, DIR_MSI_CACHE_S),
+        /* EVICT     */ TRANS_ERROR,
+        /* PUTM      */ TRANS_ERROR,
+        /* UPGRADE   */ TRANS_ERROR,
+        /* UPDATE    */ TRANS_ERROR,
+        /* DATA_EXCL */ TRANS_ERROR,
+        /* FWD_GETS  */ TRANS_ERROR,
+        /* FWD_GETM  */ TRANS_ERROR,
+        /* INV       */ TRANS (ACT_SEND_INV_ACK, DIR_MSI_CACHE_IS_Intermediate)
+    },
+    /* IM */ {
+        TRANS_ERROR,
+        /* LOAD      */ TRANS (ACT_NONE, DIR_MSI_CACHE_IM_Intermediate),
+        /* STORE     */ TRANS (ACT_NONE, DIR_MSI_CACHE_IM_Intermediate),
+        /* GETS      */ TRANS_ERROR,
+        /* GETM      */ TRANS_ERROR,
+        /* DATA      */ TRANS (ACT_SEND_DATA_PROC, DIR_MSI_CACHE_M),
+        /* EVICT     */ TRANS_ERROR,
+        /* PUTM      */ TRANS_ERROR,
+        /* UPGRADE   */ TRANS_ERROR,
+        /* UPDATE    */ TRANS_ERROR,
+        /* DATA_EXCL */ TRANS_ERROR,
+        /* FWD_GETS  */ TRANS_ERROR,
+        /* FWD_GETM  */ TRANS_ERROR,
+        /* INV       */ TRANS (ACT_SEND_INV_ACK, DIR_MSI_CACHE_IM_Intermediate)
+    },
+    /* SM */ {
+        TRANS_ERROR,
+        /* LOAD      */ TRANS (ACT_NONE, DIR_MSI_CACHE_SM_Intermediate),
+        /* STORE     */ TRANS (ACT_NONE, DIR_MSI_CACHE_SM_Intermediate),
+        /* GETS      */ TRANS_ERROR,
+        /* GETM      */ TRANS_ERROR,
+        /* DATA      */ TRANS (ACT_SEND_DATA_PROC, DIR_MSI_CACHE_M),
+        /* EVICT     */ TRANS_ERROR,
+        /* PUTM      */ TRANS_ERROR,
+        /* UPGRADE   */ TRANS (ACT_SEND_DATA_PROC | ACT_DATA_SAVED, DIR_MSI_CACHE_M),
+        /* UPDATE    */ TRANS_ERROR,
+        /* DATA_EXCL */ TRANS_ERROR,
+        /* FWD_GETS  */ TRANS_ERROR,
+        /* FWD_GETM  */ TRANS_ERROR,
+        /* INV       */ TRANS (ACT_SEND_INV_ACK, DIR_MSI_CACHE_IM_Intermediate)
+    },
+    /* MI */ {
+        TRANS_ERROR,
+        /* LOAD      */ TRANS_ERROR,
+        /* STORE     */ TRANS_ERROR,
+        /* GETS      */ TRANS_ERROR,
+        /* GETM      */ TRANS_ERROR,
+        /* DATA      */ TRANS_ERROR,
+        /* EVICT     */ TRANS_ERROR,
+        /* PUTM      */ TRANS_ERROR,
+        /* UPGRADE   */ TRANS_ERROR,
+        /* UPDATE    */ TRANS_ERROR,
+        /* DATA_EXCL */ TRANS_ERROR,
+        /* FWD_GETS  */ TRANS (ACT_SEND_DATA_BUS | ACT_SEND_INV_ACK, DIR_MSI_CACHE_MI_Intermediate),
+        /* FWD_GETM  */ TRANS (ACT_SEND_DATA_BUS | ACT_SEND_INV_ACK, DIR_MSI_CACHE_II_Intermediate),
+        /* INV       */ TRANS_ERROR,
+        /* INV_ACK   */ TRANS_ERROR,
+        /* PUT_ACK   */ TRANS (ACT_NONE, DIR_MSI_CACHE_I)
+    },
+    /* II */ {
+        TRANS_ERROR,
+        /* LOAD      */ TRANS_ERROR,
+        /* STORE     */ TRANS_ERROR,
+        /* GETS      */ TRANS_ERROR,
+        /* GETM      */ TRANS_ERROR,
+        /* DATA      */ TRANS_ERROR,
+        /* EVICT     */ TRANS_ERROR,
+        /* PUTM      */ TRANS_ERROR,
+        /* UPGRADE   */ TRANS_ERROR,
+        /* UPDATE    */ TRANS_ERROR,
+        /* DATA_EXCL */ TRANS_ERROR,
+        /* FWD_GETS  */ TRANS_ERROR,
+        /* FWD_GETM  */ TRANS_ERROR,
+        /* INV       */ TRANS (ACT_SEND_INV_ACK, DIR_MSI_CACHE_II_Intermediate),
+        /* INV_ACK   */ TRANS_ERROR,
+        /* PUT_ACK   */ TRANS (ACT_NONE, DIR_MSI_CACHE_I)
+    }
+};
+
+/** The entries set_upgrade rewrites, off (GETM and DATA, as in the validation
+ * runs) and on (UPGRADE)
+ */
+static const Transition_patch upgrade_patches[] = {
+    { DIR_MSI_CACHE_S, STORE,
+      TRANS (ACT_SEND_GETM | ACT_CACHE_MISS, DIR_MSI_CACHE_SM_Intermediate),
+      TRANS (ACT_SEND_UPGRADE | ACT_CACHE_MISS, DIR_MSI_CACHE_SM_Intermediate) },
+    { 0 }
+};
+
+void DIR_MSI_protocol::set_upgrade (bool upgrade)
+{
+    patch_transitions (upgrade_patches, upgrade);
+}
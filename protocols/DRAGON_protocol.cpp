@@ -0,0 +1,180 @@
+#include "DRAGON_protocol.h"
+#include "../sim/mreq.h"
+#include "../sim/sim.h"
+#include "../sim/hash_table.h"
+
+extern Simulator *Sim;
+
+/**
+* This file contains the methods for the Dragon protocol, a write-update snooping protocol.
+* Writes to a shared line are broadcast with UPDATE and the other copies stay
+* valid.  Sm is the shared owner of a dirty line and supplies it, Sc is a clean
+* (or not owned) shared copy.
+* A write miss reads the line and broadcasts the write in one GETM: the holders
+* supply the data and keep their copies.  A store to a shared line completes at
+* once, and whoever's UPDATE reaches the bus last becomes the owner.  E and M see
+* an UPDATE only when its sender dropped the line before the UPDATE went out.
+*/
+
+/*************************
+ * Constructor/Destructor.
+ *************************/
+DRAGON_protocol::DRAGON_protocol (Hash_table *my_table, Hash_entry *my_entry)
+    : Protocol_template<DRAGON_protocol> (my_table, my_entry)
+{
+    // Initialize lines to not have the data yet!
+    this->state = initial_state;
+}
+
+DRAGON_protocol::~DRAGON_protocol ()
+{
+}
+
+const DRAGON_cache_state_t DRAGON_protocol::initial_state = DRAGON_CACHE_I;
+
+const char *const DRAGON_protocol::name = "DRAGON";
+
+/** Same size and order as the state enum in the header */
+const char *const DRAGON_protocol::state_names[DRAGON_CACHE_NUM_STATES] = {"X", "I", "E", "Sc", "Sm", "M", "IS", "IM", "MI", "II", "SmM"};
+
+/** Same order as state_names, true for the states that supply data as the
+ * line's owner (see supplier_of) rather than as a clean forwarder
+ */
+const bool DRAGON_protocol::owner_states[DRAGON_CACHE_NUM_STATES] = {
+    /* X */ false, /* I */ false, /* E */ false, /* Sc */ false, /* Sm */ true,
+    /* M */ true, /* IS */ false, /* IM */ false, /* MI */ true, /* II */ false,
+    /* SmM */ true
+};
+
+void DRAGON_protocol::dump_state (unsigned char state)
+{
+    fprintf (stderr, "DRAGON_protocol - state: %s\n", state_names[state]);
+}
+
+/** DRAGON transitions, indexed by [state][message].  Columns are in message_t order:
+ * NOP, LOAD, STORE, GETS, GETM, DATA, EVICT, PUTM, UPGRADE, UPDATE.  Messages left
+ * out of a row are errors.
+ * Their own UPDATE moves Sc and Sm to SmM, which settles to Sm if another cache
+ * kept its copy and to M otherwise, see TRANS_SETTLE.  IS and IM are about to
+ * hold a copy, so they count as keeping one
+ */
+const Transition DRAGON_protocol::transitions[DRAGON_CACHE_NUM_STATES][MREQ_MESSAGE_NUM] = {
+    /* X */ TRANS_ROW_INVALID,
+    /* I */ {
+        TRANS_ERROR,
+        /* LOAD    */ TRANS (ACT_SEND_GETS | ACT_CACHE_MISS, DRAGON_CACHE_IS_Intermediate),
+        /* STORE   */ TRANS (ACT_SEND_GETM | ACT_CACHE_MISS, DRAGON_CACHE_IM_Intermediate),
+        /* GETS    */ TRANS (ACT_NONE, DRAGON_CACHE_I),
+        /* GETM    */ TRANS (ACT_NONE, DRAGON_CACHE_I),
+        /* DATA    */ TRANS (ACT_NONE, DRAGON_CACHE_I),
+        /* EVICT   */ TRANS (ACT_NONE, DRAGON_CACHE_I),
+        /* PUTM    */ TRANS_ERROR,
+        /* UPGRADE */ TRANS_ERROR,
+        /* UPDATE  */ TRANS (ACT_NONE, DRAGON_CACHE_I)
+    },
+    /* E */ {
+        TRANS_ERROR,
+        /* LOAD    */ TRANS (ACT_SEND_DATA_PROC, DRAGON_CACHE_E),
+        /* STORE   */ TRANS (ACT_SEND_DATA_PROC | ACT_SILENT_UPGRADE, DRAGON_CACHE_M),
+        /* GETS    */ TRANS (ACT_SET_SHARED | ACT_SEND_DATA_BUS, DRAGON_CACHE_Sc),
+        /* GETM    */ TRANS (ACT_SET_SHARED | ACT_SEND_DATA_BUS | ACT_APPLY_UPDATE, DRAGON_CACHE_Sc),
+        /* DATA    */ TRANS (ACT_NONE, DRAGON_CACHE_E),
+        /* EVICT   */ TRANS (ACT_NONE, DRAGON_CACHE_I),
+        /* PUTM    */ TRANS_ERROR,
+        /* UPGRADE */ TRANS_ERROR,
+        /* UPDATE  */ TRANS (ACT_NONE, DRAGON_CACHE_E)
+    },
+    /* Sc */ {
+        TRANS_ERROR,
+        /* LOAD    */ TRANS (ACT_SEND_DATA_PROC, DRAGON_CACHE_Sc),
+        /* STORE   */ TRANS (ACT_SEND_UPDATE | ACT_SEND_DATA_PROC, DRAGON_CACHE_Sc),
+        /* GETS    */ TRANS (ACT_SET_SHARED, DRAGON_CACHE_Sc),
+        /* GETM    */ TRANS (ACT_SET_SHARED | ACT_APPLY_UPDATE, DRAGON_CACHE_Sc),
+        /* DATA    */ TRANS (ACT_NONE, DRAGON_CACHE_Sc),
+        /* EVICT   */ TRANS (ACT_NONE, DRAGON_CACHE_I),
+        /* PUTM    */ TRANS_ERROR,
+        /* UPGRADE */ TRANS_ERROR,
+        /* UPDATE  */ TRANS_IF_OWN_UPDATE (ACT_SET_SHARED | ACT_APPLY_UPDATE, DRAGON_CACHE_SmM_Intermediate, DRAGON_CACHE_Sc)
+    },
+    /* Sm */ {
+        TRANS_ERROR,
+        /* LOAD    */ TRANS (ACT_SEND_DATA_PROC, DRAGON_CACHE_Sm),
+        /* STORE   */ TRANS (ACT_SEND_UPDATE | ACT_SEND_DATA_PROC, DRAGON_CACHE_Sm),
+        /* GETS    */ TRANS (ACT_SET_SHARED | ACT_SEND_DATA_BUS, DRAGON_CACHE_Sm),
+        /* GETM    */ TRANS (ACT_SET_SHARED | ACT_SEND_DATA_BUS | ACT_APPLY_UPDATE, DRAGON_CACHE_Sc),
+        /* DATA    */ TRANS (ACT_NONE, DRAGON_CACHE_Sm),
+        /* EVICT   */ TRANS (ACT_SEND_PUTM, DRAGON_CACHE_MI_Intermediate),
+        /* PUTM    */ TRANS_ERROR,
+        /* UPGRADE */ TRANS_ERROR,
+        /* UPDATE  */ TRANS_IF_OWN_UPDATE (ACT_SET_SHARED | ACT_APPLY_UPDATE, DRAGON_CACHE_SmM_Intermediate, DRAGON_CACHE_Sc)
+    },
+    /* M */ {
+        TRANS_ERROR,
+        /* LOAD    */ TRANS (ACT_SEND_DATA_PROC, DRAGON_CACHE_M),
+        /* STORE   */ TRANS (ACT_SEND_DATA_PROC, DRAGON_CACHE_M),
+        /* GETS    */ TRANS (ACT_SET_SHARED | ACT_SEND_DATA_BUS, DRAGON_CACHE_Sm),
+        /* GETM    */ TRANS (ACT_SET_SHARED | ACT_SEND_DATA_BUS | ACT_APPLY_UPDATE, DRAGON_CACHE_Sc),
+        /* DATA    */ TRANS (ACT_NONE, DRAGON_CACHE_M),
+        /* EVICT   */ TRANS (ACT_SEND_PUTM, DRAGON_CACHE_MI_Intermediate),
+        /* PUTM    */ TRANS_ERROR,
+        /* UPGRADE */ TRANS_ERROR,
+        /* UPDATE  */ TRANS (ACT_NONE, DRAGON_CACHE_M)
+    },
+    /* IS */ {
+        TRANS_ERROR,
+        /* LOAD    */ TRANS (ACT_NONE, DRAGON_CACHE_IS_Intermediate),
+        /* STORE   */ TRANS (ACT_NONE, DRAGON_CACHE_IS_Intermediate),
+        /* GETS    */ TRANS (ACT_NONE, DRAGON_CACHE_IS_Intermediate),
+        /* GETM    */ TRANS (ACT_NONE, DRAGON_CACHE_IS_Intermediate),
+        /* DATA    */ TRANS_IF_SHARED (ACT_SEND_DATA_PROC, DRAGON_CACHE_Sc, DRAGON_CACHE_E),
+        /* EVICT   */ TRANS_ERROR,
+        /* PUTM    */ TRANS_ERROR,
+        /* UPGRADE */ TRANS_ERROR,
+        /* UPDATE  */ TRANS (ACT_SET_SHARED, DRAGON_CACHE_IS_Intermediate)
+    },
+    /* IM */ {
+        TRANS_ERROR,
+        /* LOAD    */ TRANS (ACT_NONE, DRAGON_CACHE_IM_Intermediate),
+        /* STORE   */ TRANS (ACT_NONE, DRAGON_CACHE_IM_Intermediate),
+        /* GETS    */ TRANS (ACT_NONE, DRAGON_CACHE_IM_Intermediate),
+        /* GETM    */ TRANS (ACT_NONE, DRAGON_CACHE_IM_Intermediate),
+        /* DATA    */ TRANS_IF_SHARED (ACT_SEND_DATA_PROC, DRAGON_CACHE_Sm, DRAGON_CACHE_M),
+        /* EVICT   */ TRANS_ERROR,
+        /* PUTM    */ TRANS_ERROR,
+        /* UPGRADE */ TRANS_ERROR,
+        /* UPDATE  */ TRANS (ACT_SET_SHARED, DRAGON_CACHE_IM_Intermediate)
+    },
+    /* Evicted dirty line waiting for its PUTM to go out on the bus.  Until then
+     * memory is stale, so we keep supplying the data.  A GETM or UPDATE from
+     * someone else makes them the owner
+     */
+    /* MI */ {
+        TRANS_ERROR,
+        /* LOAD    */ TRANS_ERROR,
+        /* STORE   */ TRANS_ERROR,
+        /* GETS    */ TRANS (ACT_SET_SHARED | ACT_SEND_DATA_BUS, DRAGON_CACHE_MI_Intermediate),
+        /* GETM    */ TRANS (ACT_SET_SHARED | ACT_SEND_DATA_BUS, DRAGON_CACHE_II_Intermediate),
+        /* DATA    */ TRANS (ACT_NONE, DRAGON_CACHE_MI_Intermediate),
+        /* EVICT   */ TRANS_ERROR,
+        /* PUTM    */ TRANS (ACT_NONE, DRAGON_CACHE_I),
+        /* UPGRADE */ TRANS_ERROR,
+        /* UPDATE  */ TRANS_IF_OTHER (ACT_NONE, DRAGON_CACHE_II_Intermediate, DRAGON_CACHE_MI_Intermediate)
+    },
+    /* Someone took ownership before our PUTM went out, it carries stale data */
+    /* II */ {
+        TRANS_ERROR,
+        /* LOAD    */ TRANS_ERROR,
+        /* STORE   */ TRANS_ERROR,
+        /* GETS    */ TRANS (ACT_NONE, DRAGON_CACHE_II_Intermediate),
+        /* GETM    */ TRANS (ACT_NONE, DRAGON_CACHE_II_Intermediate),
+        /* DATA    */ TRANS (ACT_NONE, DRAGON_CACHE_II_Intermediate),
+        /* EVICT   */ TRANS_ERROR,
+        /* PUTM    */ TRANS (ACT_NONE, DRAGON_CACHE_I),
+        /* UPGRADE */ TRANS_ERROR,
+        /* UPDATE  */ TRANS (ACT_NONE, DRAGON_CACHE_II_Intermediate)
+    },
+    /* Saw its own UPDATE, settled by the next message for the line */
+    /* SmM */ {
+        TRANS_SETTLE (DRAGON_CACHE_Sm, DRAGON_CACHE_M)
+    }
+};
@@ -0,0 +1,58 @@
+#ifndef _DRAGON_CACHE_H
+#define _DRAGON_CACHE_H
+
+#include "../sim/types.h"
+#include "../sim/enums.h"
+#include "../sim/module.h"
+#include "../sim/mreq.h"
+#include "protocol_template.h"
+
+/**
+* This file contains the methods for the Dragon protocol, a write-update snooping protocol.
+* Writes to a shared line are broadcast with UPDATE and the other copies stay
+* valid.  Sm is the shared owner of a dirty line and supplies it, Sc is a clean
+* (or not owned) shared copy.
+*/
+
+/** Cache states.  */
+typedef enum {
+    DRAGON_CACHE_I = 1,
+    DRAGON_CACHE_E,
+    DRAGON_CACHE_Sc,
+    DRAGON_CACHE_Sm,
+    DRAGON_CACHE_M,
+
+    //All the intermediate states added here
+    DRAGON_CACHE_IS_Intermediate,
+    DRAGON_CACHE_IM_Intermediate,
+    DRAGON_CACHE_MI_Intermediate,
+    DRAGON_CACHE_II_Intermediate,
+    DRAGON_CACHE_SmM_Intermediate,
+    DRAGON_CACHE_NUM_STATES
+} DRAGON_cache_state_t;
+
+class DRAGON_protocol : public Protocol_template<DRAGON_protocol> {
+public:
+    typedef DRAGON_cache_state_t state_t;
+
+    DRAGON_protocol (Hash_table *my_table, Hash_entry *my_entry);
+    ~DRAGON_protocol ();
+
+    DRAGON_cache_state_t state;
+
+    /** Prints a state the way dump() does, for lines kept in a Cache_array */
+    static void dump_state (unsigned char state);
+
+    /** State every line starts in */
+    static const state_t initial_state;
+
+    static const char *const name;
+    static const char *const state_names[DRAGON_CACHE_NUM_STATES];
+    /** Dirty states, which supply data as the owner */
+    static const bool owner_states[DRAGON_CACHE_NUM_STATES];
+
+    /** Actions and next state for each [state][message], see transition_table.h */
+    static const Transition transitions[DRAGON_CACHE_NUM_STATES][MREQ_MESSAGE_NUM];
+};
+
+#endif // _DRAGON_CACHE_H
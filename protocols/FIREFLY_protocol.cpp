@@ -0,0 +1,164 @@
+#include "FIREFLY_protocol.h"
+#include "../sim/mreq.h"
+#include "../sim/sim.h"
+#include "../sim/hash_table.h"
+
+extern Simulator *Sim;
+
+/**
+* This file contains the methods for the Firefly protocol, a write-update snooping protocol.
+* Writes to a shared line are broadcast with UPDATE and written through to
+* memory, so S is always clean and there is no owned state.
+* A write miss reads the line and broadcasts the write in one GETM, so a miss
+* to a shared line ends in S.  A store to S completes at once and the line
+* goes to E if its UPDATE finds no other sharer.
+*/
+
+/*************************
+ * Constructor/Destructor.
+ *************************/
+FIREFLY_protocol::FIREFLY_protocol (Hash_table *my_table, Hash_entry *my_entry)
+    : Protocol_template<FIREFLY_protocol> (my_table, my_entry)
+{
+    // Initialize lines to not have the data yet!
+    this->state = initial_state;
+}
+
+FIREFLY_protocol::~FIREFLY_protocol ()
+{
+}
+
+const FIREFLY_cache_state_t FIREFLY_protocol::initial_state = FIREFLY_CACHE_I;
+
+const char *const FIREFLY_protocol::name = "FIREFLY";
+
+/** Same size and order as the state enum in the header */
+const char *const FIREFLY_protocol::state_names[FIREFLY_CACHE_NUM_STATES] = {"X", "I", "E", "S", "M", "IS", "IM", "MI", "II", "SE"};
+
+/** Same order as state_names, true for the states that supply data as the
+ * line's owner (see supplier_of) rather than as a clean forwarder
+ */
+const bool FIREFLY_protocol::owner_states[FIREFLY_CACHE_NUM_STATES] = {
+    /* X */ false, /* I */ false, /* E */ false, /* S */ false, /* M */ true,
+    /* IS */ false, /* IM */ false, /* MI */ true, /* II */ false, /* SE */ false
+};
+
+void FIREFLY_protocol::dump_state (unsigned char state)
+{
+    fprintf (stderr, "FIREFLY_protocol - state: %s\n", state_names[state]);
+}
+
+/** FIREFLY transitions, indexed by [state][message].  Columns are in message_t order:
+ * NOP, LOAD, STORE, GETS, GETM, DATA, EVICT, PUTM, UPGRADE, UPDATE.  Messages left
+ * out of a row are errors.
+ * Its own UPDATE moves S to SE, which settles to S if another cache kept its
+ * copy and to E otherwise, see TRANS_SETTLE.  IS and IM are about to hold a
+ * copy, so they count as keeping one
+ */
+const Transition FIREFLY_protocol::transitions[FIREFLY_CACHE_NUM_STATES][MREQ_MESSAGE_NUM] = {
+    /* X */ TRANS_ROW_INVALID,
+    /* I */ {
+        TRANS_ERROR,
+        /* LOAD    */ TRANS (ACT_SEND_GETS | ACT_CACHE_MISS, FIREFLY_CACHE_IS_Intermediate),
+        /* STORE   */ TRANS (ACT_SEND_GETM | ACT_CACHE_MISS, FIREFLY_CACHE_IM_Intermediate),
+        /* GETS    */ TRANS (ACT_NONE, FIREFLY_CACHE_I),
+        /* GETM    */ TRANS (ACT_NONE, FIREFLY_CACHE_I),
+        /* DATA    */ TRANS (ACT_NONE, FIREFLY_CACHE_I),
+        /* EVICT   */ TRANS (ACT_NONE, FIREFLY_CACHE_I),
+        /* PUTM    */ TRANS_ERROR,
+        /* UPGRADE */ TRANS_ERROR,
+        /* UPDATE  */ TRANS (ACT_NONE, FIREFLY_CACHE_I)
+    },
+    /* E */ {
+        TRANS_ERROR,
+        /* LOAD    */ TRANS (ACT_SEND_DATA_PROC, FIREFLY_CACHE_E),
+        /* STORE   */ TRANS (ACT_SEND_DATA_PROC | ACT_SILENT_UPGRADE, FIREFLY_CACHE_M),
+        /* GETS    */ TRANS (ACT_SET_SHARED | ACT_SEND_DATA_BUS, FIREFLY_CACHE_S),
+        /* GETM    */ TRANS (ACT_SET_SHARED | ACT_SEND_DATA_BUS | ACT_APPLY_UPDATE, FIREFLY_CACHE_S),
+        /* DATA    */ TRANS (ACT_NONE, FIREFLY_CACHE_E),
+        /* EVICT   */ TRANS (ACT_NONE, FIREFLY_CACHE_I),
+        /* PUTM    */ TRANS_ERROR,
+        /* UPGRADE */ TRANS_ERROR,
+        /* UPDATE  */ TRANS (ACT_NONE, FIREFLY_CACHE_E)
+    },
+    /* S */ {
+        TRANS_ERROR,
+        /* LOAD    */ TRANS (ACT_SEND_DATA_PROC, FIREFLY_CACHE_S),
+        /* STORE   */ TRANS (ACT_SEND_UPDATE | ACT_SEND_DATA_PROC, FIREFLY_CACHE_S),
+        /* GETS    */ TRANS (ACT_SET_SHARED, FIREFLY_CACHE_S),
+        /* GETM    */ TRANS (ACT_SET_SHARED | ACT_APPLY_UPDATE, FIREFLY_CACHE_S),
+        /* DATA    */ TRANS (ACT_NONE, FIREFLY_CACHE_S),
+        /* EVICT   */ TRANS (ACT_NONE, FIREFLY_CACHE_I),
+        /* PUTM    */ TRANS_ERROR,
+        /* UPGRADE */ TRANS_ERROR,
+        /* UPDATE  */ TRANS_IF_OWN_UPDATE (ACT_SET_SHARED | ACT_APPLY_UPDATE, FIREFLY_CACHE_SE_Intermediate, FIREFLY_CACHE_S)
+    },
+    /* M */ {
+        TRANS_ERROR,
+        /* LOAD    */ TRANS (ACT_SEND_DATA_PROC, FIREFLY_CACHE_M),
+        /* STORE   */ TRANS (ACT_SEND_DATA_PROC, FIREFLY_CACHE_M),
+        /* GETS    */ TRANS (ACT_SET_SHARED | ACT_SEND_DATA_BUS, FIREFLY_CACHE_S),
+        /* GETM    */ TRANS (ACT_SET_SHARED | ACT_SEND_DATA_BUS | ACT_APPLY_UPDATE, FIREFLY_CACHE_S),
+        /* DATA    */ TRANS (ACT_NONE, FIREFLY_CACHE_M),
+        /* EVICT   */ TRANS (ACT_SEND_PUTM, FIREFLY_CACHE_MI_Intermediate),
+        /* PUTM    */ TRANS_ERROR,
+        /* UPGRADE */ TRANS_ERROR,
+        /* UPDATE  */ TRANS (ACT_NONE, FIREFLY_CACHE_M)
+    },
+    /* IS */ {
+        TRANS_ERROR,
+        /* LOAD    */ TRANS (ACT_NONE, FIREFLY_CACHE_IS_Intermediate),
+        /* STORE   */ TRANS (ACT_NONE, FIREFLY_CACHE_IS_Intermediate),
+        /* GETS    */ TRANS (ACT_NONE, FIREFLY_CACHE_IS_Intermediate),
+        /* GETM    */ TRANS (ACT_NONE, FIREFLY_CACHE_IS_Intermediate),
+        /* DATA    */ TRANS_IF_SHARED (ACT_SEND_DATA_PROC, FIREFLY_CACHE_S, FIREFLY_CACHE_E),
+        /* EVICT   */ TRANS_ERROR,
+        /* PUTM    */ TRANS_ERROR,
+        /* UPGRADE */ TRANS_ERROR,
+        /* UPDATE  */ TRANS (ACT_SET_SHARED, FIREFLY_CACHE_IS_Intermediate)
+    },
+    /* IM */ {
+        TRANS_ERROR,
+        /* LOAD    */ TRANS (ACT_NONE, FIREFLY_CACHE_IM_Intermediate),
+        /* STORE   */ TRANS (ACT_NONE, FIREFLY_CACHE_IM_Intermediate),
+        /* GETS    */ TRANS (ACT_NONE, FIREFLY_CACHE_IM_Intermediate),
+        /* GETM    */ TRANS (ACT_NONE, FIREFLY_CACHE_IM_Intermediate),
+        /* DATA    */ TRANS_IF_SHARED (ACT_SEND_DATA_PROC, FIREFLY_CACHE_S, FIREFLY_CACHE_M),
+        /* EVICT   */ TRANS_ERROR,
+        /* PUTM    */ TRANS_ERROR,
+        /* UPGRADE */ TRANS_ERROR,
+        /* UPDATE  */ TRANS (ACT_SET_SHARED, FIREFLY_CACHE_IM_Intermediate)
+    },
+    /* Evicted dirty line waiting for its PUTM to go out on the bus.  Until then
+     * memory is stale, so we supply the data, which also writes it back
+     */
+    /* MI */ {
+        TRANS_ERROR,
+        /* LOAD    */ TRANS_ERROR,
+        /* STORE   */ TRANS_ERROR,
+        /* GETS    */ TRANS (ACT_SET_SHARED | ACT_SEND_DATA_BUS, FIREFLY_CACHE_II_Intermediate),
+        /* GETM    */ TRANS (ACT_SET_SHARED | ACT_SEND_DATA_BUS, FIREFLY_CACHE_II_Intermediate),
+        /* DATA    */ TRANS (ACT_NONE, FIREFLY_CACHE_MI_Intermediate),
+        /* EVICT   */ TRANS_ERROR,
+        /* PUTM    */ TRANS (ACT_NONE, FIREFLY_CACHE_I),
+        /* UPGRADE */ TRANS_ERROR,
+        /* UPDATE  */ TRANS (ACT_NONE, FIREFLY_CACHE_MI_Intermediate)
+    },
+    /* Memory picked up the data before our PUTM went out, it carries stale data */
+    /* II */ {
+        TRANS_ERROR,
+        /* LOAD    */ TRANS_ERROR,
+        /* STORE   */ TRANS_ERROR,
+        /* GETS    */ TRANS (ACT_NONE, FIREFLY_CACHE_II_Intermediate),
+        /* GETM    */ TRANS (ACT_NONE, FIREFLY_CACHE_II_Intermediate),
+        /* DATA    */ TRANS (ACT_NONE, FIREFLY_CACHE_II_Intermediate),
+        /* EVICT   */ TRANS_ERROR,
+        /* PUTM    */ TRANS (ACT_NONE, FIREFLY_CACHE_I),
+        /* UPGRADE */ TRANS_ERROR,
+        /* UPDATE  */ TRANS (ACT_NONE, FIREFLY_CACHE_II_Intermediate)
+    },
+    /* Saw its own UPDATE, settled by the next message for the line */
+    /* SE */ {
+        TRANS_SETTLE (FIREFLY_CACHE_S, FIREFLY_CACHE_E)
+    }
+};
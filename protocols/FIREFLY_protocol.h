@@ -0,0 +1,56 @@
+#ifndef _FIREFLY_CACHE_H
+#define _FIREFLY_CACHE_H
+
+#include "../sim/types.h"
+#include "../sim/enums.h"
+#include "../sim/module.h"
+#include "../sim/mreq.h"
+#include "protocol_template.h"
+
+/**
+* This file contains the methods for the Firefly protocol, a write-update snooping protocol.
+* Writes to a shared line are broadcast with UPDATE and written through to
+* memory, so S is always clean and there is no owned state.
+*/
+
+/** Cache states.  */
+typedef enum {
+    FIREFLY_CACHE_I = 1,
+    FIREFLY_CACHE_E,
+    FIREFLY_CACHE_S,
+    FIREFLY_CACHE_M,
+
+    //All the intermediate states added here
+    FIREFLY_CACHE_IS_Intermediate,
+    FIREFLY_CACHE_IM_Intermediate,
+    FIREFLY_CACHE_MI_Intermediate,
+    FIREFLY_CACHE_II_Intermediate,
+    FIREFLY_CACHE_SE_Intermediate,
+    FIREFLY_CACHE_NUM_STATES
+} FIREFLY_cache_state_t;
+
+class FIREFLY_protocol : public Protocol_template<FIREFLY_protocol> {
+public:
+    typedef FIREFLY_cache_state_t state_t;
+
+    FIREFLY_protocol (Hash_table *my_table, Hash_entry *my_entry);
+    ~FIREFLY_protocol ();
+
+    FIREFLY_cache_state_t state;
+
+    /** Prints a state the way dump() does, for lines kept in a Cache_array */
+    static void dump_state (unsigned char state);
+
+    /** State every line starts in */
+    static const state_t initial_state;
+
+    static const char *const name;
+    static const char *const state_names[FIREFLY_CACHE_NUM_STATES];
+    /** Dirty states, which supply data as the owner */
+    static const bool owner_states[FIREFLY_CACHE_NUM_STATES];
+
+    /** Actions and next state for each [state][message], see transition_table.h */
+    static const Transition transitions[FIREFLY_CACHE_NUM_STATES][MREQ_MESSAGE_NUM];
+};
+
+#endif // _FIREFLY_CACHE_H
@@ -0,0 +1,227 @@
+#include "MESIF_protocol.h"
+#include "../sim/mreq.h"
+#include "../sim/sim.h"
+#include "../sim/hash_table.h"
+
+extern Simulator *Sim;
+
+/**
+* This file contains the methods for the MESIF protocol which follows the snooping protocol.
+* E, M and F supply data for a GETS, S never does.  When F is evicted silently
+* the next GETS is served by memory and, with F migration on, that requester
+* becomes the new forwarder.
+*/
+
+/*************************
+ * Constructor/Destructor.
+ *************************/
+MESIF_protocol::MESIF_protocol (Hash_table *my_table, Hash_entry *my_entry)
+    : Protocol_template<MESIF_protocol> (my_table, my_entry)
+{
+    // Initialize lines to not have the data yet!
+    this->state = initial_state;
+}
+
+MESIF_protocol::~MESIF_protocol ()
+{
+}
+
+const MESIF_cache_state_t MESIF_protocol::initial_state = MESIF_CACHE_I;
+
+const char *const MESIF_protocol::name = "MESIF";
+
+/** Same size and order as the state enum in the header */
+const char *const MESIF_protocol::state_names[MESIF_CACHE_NUM_STATES] = {"X", "I", "S", "E", "M", "F", "IS", "IM", "SM", "FM", "MI", "II"};
+
+/** Same order as state_names, true for the states that supply data as the
+ * line's owner (see supplier_of) rather than as a clean forwarder
+ */
+const bool MESIF_protocol::owner_states[MESIF_CACHE_NUM_STATES] = {
+    /* X */ false, /* I */ false, /* S */ false, /* E */ false, /* M */ true,
+    /* F */ false, /* IS */ false, /* IM */ false, /* SM */ false, /* FM */ false,
+    /* MI */ true, /* II */ false
+};
+
+void MESIF_protocol::dump_state (unsigned char state)
+{
+    fprintf (stderr, "MESIF_protocol - state: %s\n", state_names[state]);
+}
+
+void MESIF_protocol::set_f_migrates (bool migrate)
+{
+    /* The supplier's next state after a GETS and the requester's state for a
+     * shared fill are the only entries that differ between the two policies
+     */
+    unsigned char supplier = migrate ? MESIF_CACHE_S : MESIF_CACHE_F;
+
+    transitions[MESIF_CACHE_E][GETS].next = transitions[MESIF_CACHE_E][GETS].alt = supplier;
+    transitions[MESIF_CACHE_M][GETS].next = transitions[MESIF_CACHE_M][GETS].alt = supplier;
+    transitions[MESIF_CACHE_F][GETS].next = transitions[MESIF_CACHE_F][GETS].alt = supplier;
+    /* An FM that hands F over stops being the supplier, so it waits like SM */
+    transitions[MESIF_CACHE_FM_Intermediate][GETS].next = transitions[MESIF_CACHE_FM_Intermediate][GETS].alt =
+        migrate ? MESIF_CACHE_SM_Intermediate : MESIF_CACHE_FM_Intermediate;
+    transitions[MESIF_CACHE_IS_Intermediate][DATA].next = migrate ? MESIF_CACHE_F : MESIF_CACHE_S;
+}
+
+/** MESIF transitions, indexed by [state][message].  Columns are in message_t order:
+ * NOP, LOAD, STORE, GETS, GETM, DATA, EVICT, PUTM, UPGRADE.  Messages left out of
+ * a row are errors.  The GETS entries of E, M, F and FM and the DATA entry of IS
+ * are shown with F migration on, see set_f_migrates.
+ * The entries in upgrade_patches are shown with UPGRADE off, see set_upgrade
+ */
+Transition MESIF_protocol::transitions[MESIF_CACHE_NUM_STATES][MREQ_MESSAGE_NUM] = {
+    /* X */ TRANS_ROW_INVALID,
+    /* I */ {
+        TRANS_ERROR,
+        /* LOAD    */ TRANS (ACT_SEND_GETS | ACT_CACHE_MISS, MESIF_CACHE_IS_Intermediate),
+        /* STORE   */ TRANS (ACT_SEND_GETM | ACT_CACHE_MISS, MESIF_CACHE_IM_Intermediate),
+        /* GETS    */ TRANS (ACT_NONE, MESIF_CACHE_I),
+        /* GETM    */ TRANS (ACT_NONE, MESIF_CACHE_I),
+        /* DATA    */ TRANS (ACT_NONE, MESIF_CACHE_I),
+        /* EVICT   */ TRANS (ACT_NONE, MESIF_CACHE_I),
+        /* PUTM    */ TRANS_ERROR,
+        /* UPGRADE */ TRANS (ACT_NONE, MESIF_CACHE_I)
+    },
+    /* S */ {
+        TRANS_ERROR,
+        /* LOAD    */ TRANS (ACT_SEND_DATA_PROC, MESIF_CACHE_S),
+        /* STORE   */ TRANS (ACT_SEND_GETM | ACT_CACHE_MISS, MESIF_CACHE_SM_Intermediate),
+        /* GETS    */ TRANS (ACT_SET_SHARED, MESIF_CACHE_S),
+        /* GETM    */ TRANS (ACT_NONE, MESIF_CACHE_I),
+        /* DATA    */ TRANS (ACT_NONE, MESIF_CACHE_S),
+        /* EVICT   */ TRANS (ACT_NONE, MESIF_CACHE_I),
+        /* PUTM    */ TRANS_ERROR,
+        /* UPGRADE */ TRANS (ACT_NONE, MESIF_CACHE_I)
+    },
+    /* E */ {
+        TRANS_ERROR,
+        /* LOAD    */ TRANS (ACT_SEND_DATA_PROC, MESIF_CACHE_E),
+        /* STORE   */ TRANS (ACT_SEND_DATA_PROC | ACT_SILENT_UPGRADE, MESIF_CACHE_M),
+        /* GETS    */ TRANS (ACT_SET_SHARED | ACT_SEND_DATA_BUS, MESIF_CACHE_S),
+        /* GETM    */ TRANS (ACT_SET_SHARED | ACT_SEND_DATA_BUS, MESIF_CACHE_I),
+        /* DATA    */ TRANS (ACT_NONE, MESIF_CACHE_E),
+        /* EVICT   */ TRANS (ACT_NONE, MESIF_CACHE_I),
+        /* PUTM    */ TRANS_ERROR,
+        /* UPGRADE */ TRANS (ACT_NONE, MESIF_CACHE_E)
+    },
+    /* M */ {
+        TRANS_ERROR,
+        /* LOAD    */ TRANS (ACT_SEND_DATA_PROC, MESIF_CACHE_M),
+        /* STORE   */ TRANS (ACT_SEND_DATA_PROC, MESIF_CACHE_M),
+        /* GETS    */ TRANS (ACT_SET_SHARED | ACT_SEND_DATA_BUS, MESIF_CACHE_S),
+        /* GETM    */ TRANS (ACT_SET_SHARED | ACT_SEND_DATA_BUS, MESIF_CACHE_I),
+        /* DATA    */ TRANS (ACT_NONE, MESIF_CACHE_M),
+        /* EVICT   */ TRANS (ACT_SEND_PUTM, MESIF_CACHE_MI_Intermediate),
+        /* PUTM    */ TRANS_ERROR,
+        /* UPGRADE */ TRANS (ACT_NONE, MESIF_CACHE_M)
+    },
+    /* F */ {
+        TRANS_ERROR,
+        /* LOAD    */ TRANS (ACT_SEND_DATA_PROC, MESIF_CACHE_F),
+        /* STORE   */ TRANS (ACT_SEND_GETM | ACT_CACHE_MISS, MESIF_CACHE_FM_Intermediate),
+        /* GETS    */ TRANS (ACT_SET_SHARED | ACT_SEND_DATA_BUS, MESIF_CACHE_S),
+        /* GETM    */ TRANS (ACT_SET_SHARED | ACT_SEND_DATA_BUS, MESIF_CACHE_I),
+        /* DATA    */ TRANS_ERROR,
+        /* EVICT   */ TRANS (ACT_NONE, MESIF_CACHE_I),
+        /* PUTM    */ TRANS_ERROR,
+        /* UPGRADE */ TRANS (ACT_NONE, MESIF_CACHE_I)
+    },
+    /* IS */ {
+        TRANS_ERROR,
+        /* LOAD    */ TRANS (ACT_NONE, MESIF_CACHE_IS_Intermediate),
+        /* STORE   */ TRANS (ACT_NONE, MESIF_CACHE_IS_Intermediate),
+        /* GETS    */ TRANS (ACT_NONE, MESIF_CACHE_IS_Intermediate),
+        /* GETM    */ TRANS (ACT_NONE, MESIF_CACHE_IS_Intermediate),
+        /* DATA    */ TRANS_IF_SHARED (ACT_SEND_DATA_PROC, MESIF_CACHE_F, MESIF_CACHE_E),
+        /* EVICT   */ TRANS_ERROR,
+        /* PUTM    */ TRANS_ERROR,
+        /* UPGRADE */ TRANS (ACT_NONE, MESIF_CACHE_IS_Intermediate)
+    },
+    /* IM */ {
+        TRANS_ERROR,
+        /* LOAD    */ TRANS (ACT_NONE, MESIF_CACHE_IM_Intermediate),
+        /* STORE   */ TRANS (ACT_NONE, MESIF_CACHE_IM_Intermediate),
+        /* GETS    */ TRANS (ACT_NONE, MESIF_CACHE_IM_Intermediate),
+        /* GETM    */ TRANS (ACT_NONE, MESIF_CACHE_IM_Intermediate),
+        /* DATA    */ TRANS (ACT_SEND_DATA_PROC, MESIF_CACHE_M),
+        /* EVICT   */ TRANS_ERROR,
+        /* PUTM    */ TRANS_ERROR,
+        /* UPGRADE */ TRANS_IF_OWN (ACT_SEND_GETM, MESIF_CACHE_IM_Intermediate, MESIF_CACHE_IM_Intermediate)
+    },
+    /* SM */ {
+        TRANS_ERROR,
+        /* LOAD    */ TRANS (ACT_NONE, MESIF_CACHE_SM_Intermediate),
+        /* STORE   */ TRANS (ACT_NONE, MESIF_CACHE_SM_Intermediate),
+        /* GETS    */ TRANS_IF_OTHER (ACT_SET_SHARED, MESIF_CACHE_IM_Intermediate, MESIF_CACHE_SM_Intermediate),
+        /* GETM    */ TRANS_IF_OTHER (ACT_NONE, MESIF_CACHE_IM_Intermediate, MESIF_CACHE_SM_Intermediate),
+        /* DATA    */ TRANS (ACT_SEND_DATA_PROC, MESIF_CACHE_M),
+        /* EVICT   */ TRANS_ERROR,
+        /* PUTM    */ TRANS_ERROR,
+        /* UPGRADE */ TRANS_IF_OWN (ACT_SEND_DATA_PROC | ACT_DATA_SAVED, MESIF_CACHE_M, MESIF_CACHE_IM_Intermediate)
+    },
+    /* FM */ {
+        TRANS_ERROR,
+        /* LOAD    */ TRANS (ACT_NONE, MESIF_CACHE_FM_Intermediate),
+        /* STORE   */ TRANS (ACT_NONE, MESIF_CACHE_FM_Intermediate),
+        /* GETS    */ TRANS (ACT_SET_SHARED | ACT_SEND_DATA_BUS, MESIF_CACHE_SM_Intermediate),
+        /* GETM    */ TRANS_IF_OTHER (ACT_SEND_DATA_BUS, MESIF_CACHE_IM_Intermediate, MESIF_CACHE_FM_Intermediate),
+        /* DATA    */ TRANS (ACT_SEND_DATA_PROC, MESIF_CACHE_M),
+        /* EVICT   */ TRANS_ERROR,
+        /* PUTM    */ TRANS_ERROR,
+        /* UPGRADE */ TRANS_IF_OWN (ACT_SEND_DATA_PROC | ACT_DATA_SAVED, MESIF_CACHE_M, MESIF_CACHE_IM_Intermediate)
+    },
+    /* Evicted dirty line waiting for its PUTM to go out on the bus.  Until then
+     * memory is stale, so we keep supplying the data.  A GETS flushes the line
+     * like M does and the requester may take F, so we must stop supplying
+     */
+    /* MI */ {
+        TRANS_ERROR,
+        /* LOAD    */ TRANS_ERROR,
+        /* STORE   */ TRANS_ERROR,
+        /* GETS    */ TRANS (ACT_SET_SHARED | ACT_SEND_DATA_BUS, MESIF_CACHE_II_Intermediate),
+        /* GETM    */ TRANS (ACT_SET_SHARED | ACT_SEND_DATA_BUS, MESIF_CACHE_II_Intermediate),
+        /* DATA    */ TRANS (ACT_NONE, MESIF_CACHE_MI_Intermediate),
+        /* EVICT   */ TRANS_ERROR,
+        /* PUTM    */ TRANS (ACT_NONE, MESIF_CACHE_I),
+        /* UPGRADE */ TRANS (ACT_NONE, MESIF_CACHE_MI_Intermediate)
+    },
+    /* Someone took the line before our PUTM went out, it carries stale data */
+    /* II */ {
+        TRANS_ERROR,
+        /* LOAD    */ TRANS_ERROR,
+        /* STORE   */ TRANS_ERROR,
+        /* GETS    */ TRANS (ACT_NONE, MESIF_CACHE_II_Intermediate),
+        /* GETM    */ TRANS (ACT_NONE, MESIF_CACHE_II_Intermediate),
+        /* DATA    */ TRANS (ACT_NONE, MESIF_CACHE_II_Intermediate),
+        /* EVICT   */ TRANS_ERROR,
+        /* PUTM    */ TRANS (ACT_NONE, MESIF_CACHE_I),
+        /* UPGRADE */ TRANS (ACT_NONE, MESIF_CACHE_II_Intermediate)
+    }
+};
+
+/** The entries set_upgrade rewrites, off (GETM and DATA, as in the validation
+ * runs) and on (UPGRADE)
+ */
+static const Transition_patch upgrade_patches[] = {
+    { MESIF_CACHE_S, STORE,
+      TRANS (ACT_SEND_GETM | ACT_CACHE_MISS, MESIF_CACHE_SM_Intermediate),
+      TRANS (ACT_SEND_UPGRADE | ACT_CACHE_MISS, MESIF_CACHE_SM_Intermediate) },
+    { MESIF_CACHE_F, STORE,
+      TRANS (ACT_SEND_GETM | ACT_CACHE_MISS, MESIF_CACHE_FM_Intermediate),
+      TRANS (ACT_SEND_UPGRADE | ACT_CACHE_MISS, MESIF_CACHE_FM_Intermediate) },
+    { MESIF_CACHE_SM_Intermediate, GETS,
+      TRANS_IF_OTHER (ACT_SET_SHARED, MESIF_CACHE_IM_Intermediate, MESIF_CACHE_SM_Intermediate),
+      TRANS (ACT_SET_SHARED, MESIF_CACHE_SM_Intermediate) },
+    { MESIF_CACHE_SM_Intermediate, DATA,
+      TRANS (ACT_SEND_DATA_PROC, MESIF_CACHE_M),
+      TRANS_ERROR },
+    { MESIF_CACHE_FM_Intermediate, DATA,
+      TRANS (ACT_SEND_DATA_PROC, MESIF_CACHE_M),
+      TRANS_ERROR },
+    { 0 }
+};
+
+void MESIF_protocol::set_upgrade (bool upgrade)
+{
+    patch_transitions (upgrade_patches, upgrade);
+}
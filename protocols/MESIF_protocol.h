@@ -0,0 +1,76 @@
+#ifndef _MESIF_CACHE_H
+#define _MESIF_CACHE_H
+
+#include "../sim/types.h"
+#include "../sim/enums.h"
+#include "../sim/module.h"
+#include "../sim/mreq.h"
+#include "protocol_template.h"
+
+/**
+* This file contains the methods for the MESIF protocol which follows the snooping protocol.
+* At most one sharer holds a clean line in F and answers GETS for it, so clean
+* misses are served cache to cache without an owned (dirty shared) state.
+*/
+
+/** Cache states.  */
+typedef enum {
+    MESIF_CACHE_I = 1,
+    MESIF_CACHE_S,
+    MESIF_CACHE_E,
+    MESIF_CACHE_M,
+    MESIF_CACHE_F,
+
+    //All the intermediate states added here
+    MESIF_CACHE_IS_Intermediate,
+    MESIF_CACHE_IM_Intermediate,
+    MESIF_CACHE_SM_Intermediate,
+    MESIF_CACHE_FM_Intermediate,
+    MESIF_CACHE_MI_Intermediate,
+    MESIF_CACHE_II_Intermediate,
+    MESIF_CACHE_NUM_STATES
+} MESIF_cache_state_t;
+
+class MESIF_protocol : public Protocol_template<MESIF_protocol> {
+public:
+    typedef MESIF_cache_state_t state_t;
+
+    MESIF_protocol (Hash_table *my_table, Hash_entry *my_entry);
+    ~MESIF_protocol ();
+
+    MESIF_cache_state_t state;
+
+    /** Prints a state the way dump() does, for lines kept in a Cache_array */
+    static void dump_state (unsigned char state);
+
+    /** Makes a store to a line held in S or F send UPGRADE instead of GETM and
+     * complete without a data transfer.  Off by default, which matches the
+     * validation runs.  Rewrites the table, so call it before the simulation
+     * starts.
+     */
+    static void set_upgrade (bool upgrade);
+
+    /** Chooses who holds F after a cache supplies a GETS.  With migrate set (the
+     * default) the requester takes F and the supplier drops to S, so F follows
+     * the most recent reader.  Otherwise the supplier keeps F (E and M become F)
+     * and the requester fills in S.  Rewrites the table, so call it before the
+     * simulation starts.
+     */
+    static void set_f_migrates (bool migrate);
+
+    /** State every line starts in */
+    static const state_t initial_state;
+
+    static const char *const name;
+    static const char *const state_names[MESIF_CACHE_NUM_STATES];
+    /** Dirty states, which supply data as the owner */
+    static const bool owner_states[MESIF_CACHE_NUM_STATES];
+
+    /** Actions and next state for each [state][message], see transition_table.h.
+     * Not const, set_f_migrates patches the F election entries and set_upgrade
+     * the UPGRADE ones.
+     */
+    static Transition transitions[MESIF_CACHE_NUM_STATES][MREQ_MESSAGE_NUM];
+};
+
+#endif // _MESIF_CACHE_H
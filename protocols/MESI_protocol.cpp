@@ -15,264 +15,165 @@ extern Simulator *Sim;
  *************************/
  
 MESI_protocol::MESI_protocol (Hash_table *my_table, Hash_entry *my_entry)
-    : Protocol (my_table, my_entry)
+    : Protocol_template<MESI_protocol> (my_table, my_entry)
 {
     // Initialize lines to not have the data yet!
-    this->state = MESI_CACHE_I;
+    this->state = initial_state;
 }
 
 MESI_protocol::~MESI_protocol ()
 {
 }
 
-void MESI_protocol::dump (void)
-{
-    const char *block_states[8] = {"X","I","S","E","M", "IS", "IM", "SM"};
-    fprintf (stderr, "MESI_protocol - state: %s\n", block_states[state]);
-}
-
-void MESI_protocol::process_cache_request (Mreq *request)
-{
-    switch (state) {
-    case MESI_CACHE_I:  do_cache_I (request); break;
-    case MESI_CACHE_S:  do_cache_S (request); break;
-    case MESI_CACHE_E:  do_cache_E (request); break;
-    case MESI_CACHE_M:  do_cache_M (request); break;
-    case MESI_CACHE_IM_Intermediate: break;
-    case MESI_CACHE_IS_Intermediate: break;
-    case MESI_CACHE_SM_Intermediate: break;
-    default:
-        fatal_error ("Invalid Cache State for MESI Protocol\n");
-        break;
-    }
-}
-
-void MESI_protocol::process_snoop_request (Mreq *request)
-{
-    switch (state) {
-    case MESI_CACHE_I:  
-    	do_snoop_I (request); 
-    	break;
-    case MESI_CACHE_S:  
-    	do_snoop_S (request); 
-    	break;
-    case MESI_CACHE_E:  
-    	do_snoop_E (request); 
-    	break;
-    case MESI_CACHE_M:  
-    	do_snoop_M (request); 
-    	break;
-    case MESI_CACHE_IS_Intermediate:  
-    	do_snoop_IS_Intermediate (request); 
-    	break;
-    case MESI_CACHE_IM_Intermediate:  
-    	do_snoop_IM_Intermediate (request); 
-    	break;
-    case MESI_CACHE_SM_Intermediate:  
-    	do_snoop_SM_Intermediate (request); 
-    	break;
-    default:
-        fatal_error ("Invalid Cache State for MESI Protocol\n");
-    }
-}
-
-inline void MESI_protocol::do_cache_I (Mreq *request)
-{
-    switch (request->msg) {
-    case LOAD:
-        //this will lead to a cache miss
-    	//get the data first from the memory with the intent to share
-        send_GETS(request->addr);
-        state = MESI_CACHE_IS_Intermediate;
-        Sim->cache_misses++;
-        break;
-    case STORE:
-    	//this will lead to a cache miss
-    	//get the data first from the memory with the intent to modify
-        send_GETM(request->addr);
-        state = MESI_CACHE_IM_Intermediate;
-        Sim->cache_misses++;
-        break;
-    default:
-        request->print_msg (my_table->moduleID, "ERROR");
-        fatal_error ("Client: I state shouldn't see this message\n");
-    }
-}
-
-inline void MESI_protocol::do_cache_S (Mreq *request)
-{
-    switch (request->msg) {
-    case LOAD:
-    	//data is clean and can be sent to the processor
-        send_DATA_to_proc(request->addr);
-        break;
-    case STORE:
-    	//put the request on the bus for block with the intent to modify
-        send_GETM(request->addr);
-        state = MESI_CACHE_SM_Intermediate;
-        Sim->cache_misses++;
-        break;
-    default:
-        request->print_msg (my_table->moduleID, "ERROR");
-        fatal_error ("Client: I state shouldn't see this message\n");
-    }
-}
-
-inline void MESI_protocol::do_cache_E (Mreq *request)
-{
-    switch (request->msg) {
-    case LOAD:
-        send_DATA_to_proc(request->addr);
-        break;
-    case STORE:
-    	//now we can send the data to the processor
-        send_DATA_to_proc(request->addr);
-        state = MESI_CACHE_M;
-        Sim->silent_upgrades++;
-        break;
-    default:
-        request->print_msg (my_table->moduleID, "ERROR");
-        fatal_error ("Client: I state shouldn't see this message\n");
+const MESI_cache_state_t MESI_protocol::initial_state = MESI_CACHE_I;
+
+const char *const MESI_protocol::name = "MESI";
+
+/** Same size and order as the state enum in the header */
+const char *const MESI_protocol::state_names[MESI_CACHE_NUM_STATES] = {"X","I","S","E","M", "IS", "IM", "SM", "MI", "II"};
+
+/** Same order as state_names, true for the states that supply data as the
+ * line's owner (see supplier_of) rather than as a clean forwarder
+ */
+const bool MESI_protocol::owner_states[MESI_CACHE_NUM_STATES] = {
+    /* X */ false, /* I */ false, /* S */ false, /* E */ false, /* M */ true,
+    /* IS */ false, /* IM */ false, /* SM */ false, /* MI */ true, /* II */ false
+};
+
+void MESI_protocol::dump_state (unsigned char state)
+{
+    fprintf (stderr, "MESI_protocol - state: %s\n", state_names[state]);
+}
+
+/** MESI transitions, indexed by [state][message].  Columns are in message_t order:
+ * NOP, LOAD, STORE, GETS, GETM, DATA, EVICT, PUTM, UPGRADE.  Messages left out of
+ * a row are errors.
+ * The entries in upgrade_patches are shown with UPGRADE off, see set_upgrade
+ */
+Transition MESI_protocol::transitions[MESI_CACHE_NUM_STATES][MREQ_MESSAGE_NUM] = {
+    /* X */ TRANS_ROW_INVALID,
+    /* I */ {
+        TRANS_ERROR,
+        /* LOAD    */ TRANS (ACT_SEND_GETS | ACT_CACHE_MISS, MESI_CACHE_IS_Intermediate),
+        /* STORE   */ TRANS (ACT_SEND_GETM | ACT_CACHE_MISS, MESI_CACHE_IM_Intermediate),
+        /* GETS    */ TRANS (ACT_NONE, MESI_CACHE_I),
+        /* GETM    */ TRANS (ACT_NONE, MESI_CACHE_I),
+        /* DATA    */ TRANS (ACT_NONE, MESI_CACHE_I),
+        /* EVICT   */ TRANS (ACT_NONE, MESI_CACHE_I),
+        /* PUTM    */ TRANS_ERROR,
+        /* UPGRADE */ TRANS (ACT_NONE, MESI_CACHE_I)
+    },
+    /* S */ {
+        TRANS_ERROR,
+        /* LOAD    */ TRANS (ACT_SEND_DATA_PROC, MESI_CACHE_S),
+        /* STORE   */ TRANS (ACT_SEND_GETM | ACT_CACHE_MISS, MESI_CACHE_SM_Intermediate),
+        /* GETS    */ TRANS (ACT_SET_SHARED, MESI_CACHE_S),
+        /* GETM    */ TRANS (ACT_NONE, MESI_CACHE_I),
+        /* DATA    */ TRANS (ACT_NONE, MESI_CACHE_S),
+        /* EVICT   */ TRANS (ACT_NONE, MESI_CACHE_I),
+        /* PUTM    */ TRANS_ERROR,
+        /* UPGRADE */ TRANS (ACT_NONE, MESI_CACHE_I)
+    },
+    /* E */ {
+        TRANS_ERROR,
+        /* LOAD    */ TRANS (ACT_SEND_DATA_PROC, MESI_CACHE_E),
+        /* STORE   */ TRANS (ACT_SEND_DATA_PROC | ACT_SILENT_UPGRADE, MESI_CACHE_M),
+        /* GETS    */ TRANS (ACT_SET_SHARED | ACT_SEND_DATA_BUS, MESI_CACHE_S),
+        /* GETM    */ TRANS (ACT_SET_SHARED | ACT_SEND_DATA_BUS, MESI_CACHE_I),
+        /* DATA    */ TRANS (ACT_NONE, MESI_CACHE_E),
+        /* EVICT   */ TRANS (ACT_NONE, MESI_CACHE_I),
+        /* PUTM    */ TRANS_ERROR,
+        /* UPGRADE */ TRANS (ACT_NONE, MESI_CACHE_E)
+    },
+    /* M */ {
+        TRANS_ERROR,
+        /* LOAD    */ TRANS (ACT_SEND_DATA_PROC, MESI_CACHE_M),
+        /* STORE   */ TRANS (ACT_SEND_DATA_PROC, MESI_CACHE_M),
+        /* GETS    */ TRANS (ACT_SET_SHARED | ACT_SEND_DATA_BUS, MESI_CACHE_S),
+        /* GETM    */ TRANS (ACT_SET_SHARED | ACT_SEND_DATA_BUS, MESI_CACHE_I),
+        /* DATA    */ TRANS (ACT_NONE, MESI_CACHE_M),
+        /* EVICT   */ TRANS (ACT_SEND_PUTM, MESI_CACHE_MI_Intermediate),
+        /* PUTM    */ TRANS_ERROR,
+        /* UPGRADE */ TRANS (ACT_NONE, MESI_CACHE_M)
+    },
+    /* IS */ {
+        TRANS_ERROR,
+        /* LOAD    */ TRANS (ACT_NONE, MESI_CACHE_IS_Intermediate),
+        /* STORE   */ TRANS (ACT_NONE, MESI_CACHE_IS_Intermediate),
+        /* GETS    */ TRANS (ACT_NONE, MESI_CACHE_IS_Intermediate),
+        /* GETM    */ TRANS (ACT_NONE, MESI_CACHE_IS_Intermediate),
+        /* DATA    */ TRANS_IF_SHARED (ACT_SEND_DATA_PROC, MESI_CACHE_S, MESI_CACHE_E),
+        /* EVICT   */ TRANS_ERROR,
+        /* PUTM    */ TRANS_ERROR,
+        /* UPGRADE */ TRANS (ACT_NONE, MESI_CACHE_IS_Intermediate)
+    },
+    /* IM */ {
+        TRANS_ERROR,
+        /* LOAD    */ TRANS (ACT_NONE, MESI_CACHE_IM_Intermediate),
+        /* STORE   */ TRANS (ACT_NONE, MESI_CACHE_IM_Intermediate),
+        /* GETS    */ TRANS (ACT_NONE, MESI_CACHE_IM_Intermediate),
+        /* GETM    */ TRANS (ACT_NONE, MESI_CACHE_IM_Intermediate),
+        /* DATA    */ TRANS (ACT_SEND_DATA_PROC, MESI_CACHE_M),
+        /* EVICT   */ TRANS_ERROR,
+        /* PUTM    */ TRANS_ERROR,
+        /* UPGRADE */ TRANS_IF_OWN (ACT_SEND_GETM, MESI_CACHE_IM_Intermediate, MESI_CACHE_IM_Intermediate)
+    },
+    /* SM */ {
+        TRANS_ERROR,
+        /* LOAD    */ TRANS (ACT_NONE, MESI_CACHE_SM_Intermediate),
+        /* STORE   */ TRANS (ACT_NONE, MESI_CACHE_SM_Intermediate),
+        /* GETS    */ TRANS_IF_OTHER (ACT_SET_SHARED, MESI_CACHE_IM_Intermediate, MESI_CACHE_SM_Intermediate),
+        /* GETM    */ TRANS_IF_OTHER (ACT_NONE, MESI_CACHE_IM_Intermediate, MESI_CACHE_SM_Intermediate),
+        /* DATA    */ TRANS (ACT_SEND_DATA_PROC, MESI_CACHE_M),
+        /* EVICT   */ TRANS_ERROR,
+        /* PUTM    */ TRANS_ERROR,
+        /* UPGRADE */ TRANS_IF_OWN (ACT_SEND_DATA_PROC | ACT_DATA_SAVED, MESI_CACHE_M, MESI_CACHE_IM_Intermediate)
+    },
+    /* Evicted dirty line waiting for its PUTM to go out on the bus.  Until then
+     * memory is stale, so we keep supplying the data
+     */
+    /* MI */ {
+        TRANS_ERROR,
+        /* LOAD    */ TRANS_ERROR,
+        /* STORE   */ TRANS_ERROR,
+        /* GETS    */ TRANS (ACT_SET_SHARED | ACT_SEND_DATA_BUS, MESI_CACHE_MI_Intermediate),
+        /* GETM    */ TRANS (ACT_SET_SHARED | ACT_SEND_DATA_BUS, MESI_CACHE_II_Intermediate),
+        /* DATA    */ TRANS (ACT_NONE, MESI_CACHE_MI_Intermediate),
+        /* EVICT   */ TRANS_ERROR,
+        /* PUTM    */ TRANS (ACT_NONE, MESI_CACHE_I),
+        /* UPGRADE */ TRANS (ACT_NONE, MESI_CACHE_MI_Intermediate)
+    },
+    /* Someone took the line before our PUTM went out, it carries stale data */
+    /* II */ {
+        TRANS_ERROR,
+        /* LOAD    */ TRANS_ERROR,
+        /* STORE   */ TRANS_ERROR,
+        /* GETS    */ TRANS (ACT_NONE, MESI_CACHE_II_Intermediate),
+        /* GETM    */ TRANS (ACT_NONE, MESI_CACHE_II_Intermediate),
+        /* DATA    */ TRANS (ACT_NONE, MESI_CACHE_II_Intermediate),
+        /* EVICT   */ TRANS_ERROR,
+        /* PUTM    */ TRANS (ACT_NONE, MESI_CACHE_I),
+        /* UPGRADE */ TRANS (ACT_NONE, MESI_CACHE_II_Intermediate)
     }
-}
-
-inline void MESI_protocol::do_cache_M (Mreq *request)
-{
-    switch (request->msg) {
-    case LOAD:
-    case STORE:
-    	//now we can send the data to the processor
-        send_DATA_to_proc(request->addr);
-        break;
-    default:
-        request->print_msg (my_table->moduleID, "ERROR");
-        fatal_error ("Client: I state shouldn't see this message\n");
-    }
-}
-
-inline void MESI_protocol::do_snoop_I (Mreq *request)
-{
-    /**
-    * If we snoop a message from another cache and we are in I, then we don't
-    * need to do anything!  We obviously cannot supply data since we don't have
-    * it, and we don't need to downgrade our state since we are already in I.
-    */
-    switch (request->msg) {
-    case GETS: break;
-    case GETM: break;
-    case DATA: break;
-    default:
-        request->print_msg (my_table->moduleID, "ERROR");
-        fatal_error ("Client: I state shouldn't see this message\n");
-    }
-}
-
-inline void MESI_protocol::do_snoop_S (Mreq *request)
-{
-    switch (request->msg) {
-    case GETS:
-        set_shared_line();
-        break;
-    case GETM:
-        state = MESI_CACHE_I;
-        break;
-    case DATA: break;
-    default:
-        request->print_msg (my_table->moduleID, "ERROR");
-        fatal_error ("Client: I state shouldn't see this message\n");
-    }
-}
-
-inline void MESI_protocol::do_snoop_E (Mreq *request)
-{
-    switch (request->msg) {
-    case GETS:
-        set_shared_line();
-        send_DATA_on_bus(request->addr,request->src_mid);
-        state = MESI_CACHE_S;
-        break;
-    case GETM:
-        set_shared_line();
-        send_DATA_on_bus(request->addr,request->src_mid);
-        state = MESI_CACHE_I;
-        break;
-    case DATA: break;
-    default:
-        request->print_msg (my_table->moduleID, "ERROR");
-        fatal_error ("Client: I state shouldn't see this message\n");
-    }
-}
-
-inline void MESI_protocol::do_snoop_M (Mreq *request)
-{
-    switch (request->msg) {
-    case GETS:
-        set_shared_line();
-        send_DATA_on_bus(request->addr,request->src_mid);
-        state = MESI_CACHE_S;
-        break;
-    case GETM:
-        set_shared_line();
-        send_DATA_on_bus(request->addr,request->src_mid);
-        state = MESI_CACHE_I;
-        break;
-    case DATA: break;
-    default:
-        request->print_msg (my_table->moduleID, "ERROR");
-        fatal_error ("Client: I state shouldn't see this message\n");
-    }
-}
-
-inline void MESI_protocol::do_snoop_IS_Intermediate (Mreq *request)
-{
-    switch (request->msg) {
-    case GETS: break;
-    case GETM: break;
-    case DATA:
-        if (get_shared_line()){
-            state = MESI_CACHE_S;
-        } else{
-            state = MESI_CACHE_E;            
-        }
-        send_DATA_to_proc(request->addr);
-        break;
-    default:
-        request->print_msg (my_table->moduleID, "ERROR");
-        fatal_error ("Client: I state shouldn't see this message\n");
-    }
-}
-
-inline void MESI_protocol::do_snoop_IM_Intermediate (Mreq *request)
-{
-    switch (request->msg) {
-    case GETS: break;
-    case GETM: break;
-    case DATA:
-        state = MESI_CACHE_M;
-        send_DATA_to_proc(request->addr);
-        break;
-    default:
-        request->print_msg (my_table->moduleID, "ERROR");
-        fatal_error ("Client: I state shouldn't see this message\n");
-    }
-}
-
-inline void MESI_protocol::do_snoop_SM_Intermediate (Mreq *request)
-{
-	switch (request->msg) {
-	case GETS:
-		set_shared_line();
-	case GETM:
-		if (request->src_mid != my_table->moduleID){
-			state = MESI_CACHE_IM_Intermediate;
-		}
-		break;
-	case DATA:
-		send_DATA_to_proc(request->addr);
-		state = MESI_CACHE_M;
-		break;
-	default:
-        request->print_msg (my_table->moduleID, "ERROR");
-        fatal_error ("Client: I state shouldn't see this message\n");
-	}
+};
+
+/** The entries set_upgrade rewrites, off (GETM and DATA, as in the validation
+ * runs) and on (UPGRADE)
+ */
+static const Transition_patch upgrade_patches[] = {
+    { MESI_CACHE_S, STORE,
+      TRANS (ACT_SEND_GETM | ACT_CACHE_MISS, MESI_CACHE_SM_Intermediate),
+      TRANS (ACT_SEND_UPGRADE | ACT_CACHE_MISS, MESI_CACHE_SM_Intermediate) },
+    { MESI_CACHE_SM_Intermediate, GETS,
+      TRANS_IF_OTHER (ACT_SET_SHARED, MESI_CACHE_IM_Intermediate, MESI_CACHE_SM_Intermediate),
+      TRANS (ACT_SET_SHARED, MESI_CACHE_SM_Intermediate) },
+    { MESI_CACHE_SM_Intermediate, DATA,
+      TRANS (ACT_SEND_DATA_PROC, MESI_CACHE_M),
+      TRANS_ERROR },
+    { 0 }
+};
+
+void MESI_protocol::set_upgrade (bool upgrade)
+{
+    patch_transitions (upgrade_patches, upgrade);
 }
@@ -5,40 +5,41 @@
 #include "../sim/enums.h"
 #include "../sim/module.h"
 #include "../sim/mreq.h"
-#include "protocol.h"
+#include "protocol_template.h"
 
 /** Cache states.  */
 typedef enum {
     MI_CACHE_I = 1,
     MI_CACHE_IM,
     MI_CACHE_M,
+    MI_CACHE_MI,
+    MI_CACHE_II,
+    MI_CACHE_NUM_STATES
 } MI_cache_state_t;
 
-class MI_protocol : public Protocol {
+class MI_protocol : public Protocol_template<MI_protocol> {
 public:
+    typedef MI_cache_state_t state_t;
+
     MI_protocol (Hash_table *my_table, Hash_entry *my_entry);
     ~MI_protocol ();
 
     // Cache state for this line
     MI_cache_state_t state;
     
-    void process_cache_request (Mreq *request);
-    void process_snoop_request (Mreq *request);
-    void dump (void);
-
-    /* Functions that specify the actions to take on requests from the processor
-     * when the cache is in various states
-     */
-    inline void do_cache_I (Mreq *request);
-    inline void do_cache_IM (Mreq * request);
-    inline void do_cache_M (Mreq *request);
-
-    /* Functions that specify the actions to take on snooped requests
-     * when the cache is in various states
-     */
-    inline void do_snoop_I (Mreq *request);
-    inline void do_snoop_IM (Mreq * request);
-    inline void do_snoop_M (Mreq *request);
+    /** Prints a state the way dump() does, for lines kept in a Cache_array */
+    static void dump_state (unsigned char state);
+
+    /** State every line starts in */
+    static const state_t initial_state;
+
+    static const char *const name;
+    static const char *const state_names[MI_CACHE_NUM_STATES];
+    /** Dirty states, which supply data as the owner */
+    static const bool owner_states[MI_CACHE_NUM_STATES];
+
+    /** Actions and next state for each [state][message], see transition_table.h */
+    static const Transition transitions[MI_CACHE_NUM_STATES][MREQ_MESSAGE_NUM];
 };
 
 #endif // _MI_CACHE_H
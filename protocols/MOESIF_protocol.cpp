@@ -14,408 +14,239 @@ extern Simulator *Sim;
  * Constructor/Destructor.
  *************************/
 MOESIF_protocol::MOESIF_protocol (Hash_table *my_table, Hash_entry *my_entry)
-    : Protocol (my_table, my_entry)
+    : Protocol_template<MOESIF_protocol> (my_table, my_entry)
 {
     // Initialize lines to not have the data yet!
-    this->state = MOESIF_CACHE_I;
+    this->state = initial_state;
 }
 
 MOESIF_protocol::~MOESIF_protocol ()
 {    
 }
 
-void MOESIF_protocol::dump (void)
-{
-    const char *block_states[12] = {"X", "I", "S", "E", "O", "M", "F", "IS", "IM", "SM", "OM", "FM"};
-    fprintf (stderr, "MOESIF_protocol - state: %s\n", block_states[state]);
-}
-
-void MOESIF_protocol::process_cache_request (Mreq *request)
-{
-	switch (state) {
-    case MOESIF_CACHE_F:  do_cache_F (request); break;
-    case MOESIF_CACHE_I:  do_cache_I (request); break;
-    case MOESIF_CACHE_S:  do_cache_S (request); break;
-    case MOESIF_CACHE_E:  do_cache_E (request); break;
-    case MOESIF_CACHE_O:  do_cache_O (request); break;
-    case MOESIF_CACHE_M:  do_cache_M (request); break;
-    case MOESIF_CACHE_IM_Intermediate: break;
-    case MOESIF_CACHE_IS_Intermediate: break;
-    case MOESIF_CACHE_SM_Intermediate: break;
-    case MOESIF_CACHE_OM_Intermediate: break;
-    case MOESIF_CACHE_FM_Intermediate: break;
-    default:
-        fatal_error ("Invalid Cache State for MOESIF Protocol\n");
-    }
-}
-
-void MOESIF_protocol::process_snoop_request (Mreq *request)
-{
-	switch (state) {
-    case MOESIF_CACHE_F:  
-    	do_snoop_F (request); 
-    	break;
-    case MOESIF_CACHE_I:  
-    	do_snoop_I (request); 
-    	break;
-    case MOESIF_CACHE_S:  
-    	do_snoop_S (request);
-    	break;
-    case MOESIF_CACHE_E:  
-    	do_snoop_E (request); 
-    	break;
-    case MOESIF_CACHE_O:  
-    	do_snoop_O (request); 
-    	break;
-    case MOESIF_CACHE_M:  
-    	do_snoop_M (request); 
-    	break;
-    case MOESIF_CACHE_IM_Intermediate:  
-    	do_snoop_IM_Intermediate (request); 
-    	break;
-    case MOESIF_CACHE_IS_Intermediate:  
-    	do_snoop_IS_Intermediate (request); 
-    	break;
-    case MOESIF_CACHE_SM_Intermediate:  
-    	do_snoop_SM_Intermediate (request); 
-    	break;
-    case MOESIF_CACHE_OM_Intermediate:  
-    	do_snoop_OM_Intermediate (request); 
-    	break;
-    case MOESIF_CACHE_FM_Intermediate:  
-    	do_snoop_FM_Intermediate (request); 
-    	break;
-    default:
-    	fatal_error ("Invalid Cache State for MOESIF Protocol\n");
-    }
-}
-
-inline void MOESIF_protocol::do_cache_F (Mreq *request)
-{
-    switch (request->msg) {
-    case LOAD:
-    	//data is clean and can be sent to the processor
-        send_DATA_to_proc(request->addr);
-        break;
-    case STORE:
-    	//put the request on the bus for block with the intent to modify
-    	//this will lead to a cache miss
-        send_GETM(request->addr);
-        state = MOESIF_CACHE_FM_Intermediate;
-        Sim->cache_misses++;
-        break;
-    default:
-        request->print_msg (my_table->moduleID, "ERROR");
-        fatal_error ("Client: I state shouldn't see this message\n");
-    }
-}
-
-inline void MOESIF_protocol::do_cache_I (Mreq *request)
-{
-    switch (request->msg) {
-    case LOAD:
-        //this will lead to a cache miss
-    	//get the data first from the memory with the intent to share
-        send_GETS(request->addr);
-        state = MOESIF_CACHE_IS_Intermediate;
-        Sim->cache_misses++;
-        break;
-    case STORE:
-    	//this will lead to a cache miss
-    	//get the data first from the memory with the intent to modify
-        send_GETM(request->addr);
-        state = MOESIF_CACHE_IM_Intermediate;
-        Sim->cache_misses++;
-        break;
-    default:
-        request->print_msg (my_table->moduleID, "ERROR");
-        fatal_error ("Client: I state shouldn't see this message\n");
-    }
-}
-
-inline void MOESIF_protocol::do_cache_S (Mreq *request)
-{
-    switch (request->msg) {
-    case LOAD:
-    	//data is clean and can be sent to the processor
-        send_DATA_to_proc(request->addr);
-        break;
-    case STORE:
-    	//put the request on the bus for block with the intent to modify
-    	//this will lead to a cache miss
-        send_GETM(request->addr);
-        state = MOESIF_CACHE_IM_Intermediate;
-        Sim->cache_misses++;
-        break;
-    default:
-        request->print_msg (my_table->moduleID, "ERROR");
-        fatal_error ("Client: I state shouldn't see this message\n");
-    }
-}
-
-inline void MOESIF_protocol::do_cache_E (Mreq *request)
-{
-    switch (request->msg) {
-    case LOAD:
-        send_DATA_to_proc(request->addr);
-        break;
-    case STORE:
-    	//now we can send the data to the processor
-        send_DATA_to_proc(request->addr);
-        state = MOESIF_CACHE_M;
-        Sim->silent_upgrades++;
-        break;
-    default:
-        request->print_msg (my_table->moduleID, "ERROR");
-        fatal_error ("Client: I state shouldn't see this message\n");
-    }
-}
-
-inline void MOESIF_protocol::do_cache_O (Mreq *request)
-{
-    switch (request->msg) {
-    case LOAD:
-    	//data is clean and can be sent to the processor
-        send_DATA_to_proc(request->addr);
-        break;
-    case STORE:
-    	//put the request on the bus for block with the intent to modify
-    	//this will lead to a cache miss
-        send_GETM(request->addr);
-        state = MOESIF_CACHE_OM_Intermediate;
-        Sim->cache_misses++;
-        break;
-    default:
-        request->print_msg (my_table->moduleID, "ERROR");
-        fatal_error ("Client: I state shouldn't see this message\n");
-    }
-}
-
-inline void MOESIF_protocol::do_cache_M (Mreq *request)
-{
-    switch (request->msg) {
-    case LOAD:
-    case STORE:
-    	//now we can send the data to the processor
-        send_DATA_to_proc(request->addr);
-        break;
-    default:
-        request->print_msg (my_table->moduleID, "ERROR");
-        fatal_error ("Client: I state shouldn't see this message\n");
-    }
-}
-
-inline void MOESIF_protocol::do_snoop_F (Mreq *request)
-{
-	switch (request->msg) {
-		case GETS:
-            set_shared_line();
-            send_DATA_on_bus(request->addr, request->src_mid);
-            break;
-       	case GETM:
-          	state = MOESIF_CACHE_I;
-            set_shared_line();
-            send_DATA_on_bus(request->addr, request->src_mid);
-            break;
-       	 case DATA:
-         	default:
-        request->print_msg (my_table->moduleID, "ERROR");
-        fatal_error ("Client: I state shouldn't see this message\n");
-	}
-}
-
-inline void MOESIF_protocol::do_snoop_I (Mreq *request)
-{
-    /**
-    * If we snoop a message from another cache and we are in I, then we don't
-    * need to do anything!  We obviously cannot supply data since we don't have
-    * it, and we don't need to downgrade our state since we are already in I.
-    */
-    switch (request->msg) {
-    case GETS: break;
-    case GETM: break;
-    case DATA: break;
-    default:
-        request->print_msg (my_table->moduleID, "ERROR");
-        fatal_error ("Client: I state shouldn't see this message\n");
-    }
-}
-
-inline void MOESIF_protocol::do_snoop_S (Mreq *request)
-{
-    switch (request->msg) {
-    case GETS:
-        set_shared_line();
-        break;
-    case GETM:
-        state = MOESIF_CACHE_I;
-        break;
-    case DATA: break;
-    default:
-        request->print_msg (my_table->moduleID, "ERROR");
-        fatal_error ("Client: I state shouldn't see this message\n");
-    }
-}
-
-inline void MOESIF_protocol::do_snoop_E (Mreq *request)
-{
-    switch (request->msg) {
-    case GETS:
-        set_shared_line();
-        send_DATA_on_bus(request->addr,request->src_mid);
-        state = MOESIF_CACHE_F;
-        break;
-    case GETM:
-        set_shared_line();
-        send_DATA_on_bus(request->addr,request->src_mid);
-        state = MOESIF_CACHE_I;
-        break;
-    case DATA: break;
-    default:
-        request->print_msg (my_table->moduleID, "ERROR");
-        fatal_error ("Client: I state shouldn't see this message\n");
-    }
-}
-
-inline void MOESIF_protocol::do_snoop_O (Mreq *request)
-{
-    switch (request->msg) {
-    case GETS:
-        set_shared_line();
-        send_DATA_on_bus(request->addr,request->src_mid);
-        break;
-    case GETM:
-        set_shared_line();
-        send_DATA_on_bus(request->addr,request->src_mid);
-        state = MOESIF_CACHE_I;
-        break;
-    case DATA: 
-        break;
-    default:
-        request->print_msg (my_table->moduleID, "ERROR");
-        fatal_error ("Client: I state shouldn't see this message\n");
-    }
-}
-
-inline void MOESIF_protocol::do_snoop_M (Mreq *request)
-{
-    switch (request->msg) {
-    case GETS:
-        set_shared_line();
-        send_DATA_on_bus(request->addr,request->src_mid);
-        state = MOESIF_CACHE_O;
-        break;
-    case GETM:
-        set_shared_line();
-        send_DATA_on_bus(request->addr,request->src_mid);
-        state = MOESIF_CACHE_I;
-        break;
-    case DATA: break;
-    default:
-        request->print_msg (my_table->moduleID, "ERROR");
-        fatal_error ("Client: I state shouldn't see this message\n");
-    }
-}
-
-
-inline void MOESIF_protocol::do_snoop_IS_Intermediate (Mreq *request)
-{
-	switch (request->msg) {
-	case GETS:
-	case GETM:
-		break;
-	case DATA:
-		send_DATA_to_proc(request->addr);
-		
-		if (get_shared_line())
-		{
-			state = MOESIF_CACHE_S;
-		}
-		else{
-			state = MOESIF_CACHE_E;
-		}
-		break;
-	default:
-        request->print_msg (my_table->moduleID, "ERROR");
-        fatal_error ("Client: I state shouldn't see this message\n");
-	}
-}
-
-inline void MOESIF_protocol::do_snoop_IM_Intermediate (Mreq *request)
-{
-    switch (request->msg) {
-    case GETS: break;
-    case GETM: break;
-    case DATA:
-        send_DATA_to_proc(request->addr);
-        state = MOESIF_CACHE_M;            
-        break;
-    default:
-        request->print_msg (my_table->moduleID, "ERROR");
-        fatal_error ("Client: I state shouldn't see this message\n");
-    }
-}
-
-inline void MOESIF_protocol::do_snoop_SM_Intermediate (Mreq *request)
-{
-	switch (request->msg) {
-	case GETS:
-		set_shared_line();
-	case GETM:
-		if (request->src_mid != my_table->moduleID){
-			state = MOESIF_CACHE_IM_Intermediate;
-		}
-		break;
-	case DATA:
-		send_DATA_to_proc(request->addr);
-		state = MOESIF_CACHE_M;
-		
-		break;
-	default:
-        request->print_msg (my_table->moduleID, "ERROR");
-        fatal_error ("Client: I state shouldn't see this message\n");
-	}
-}
-
-inline void MOESIF_protocol::do_snoop_OM_Intermediate (Mreq *request)
-{
-	switch (request->msg) {
-	case GETS:
-		set_shared_line();
-		send_DATA_on_bus(request->addr,request->src_mid);
-		break;
-	case GETM:
-		send_DATA_on_bus(request->addr,request->src_mid);
-		state = MOESIF_CACHE_IM_Intermediate;
-		break;
-	case DATA:
-		state = MOESIF_CACHE_M;
-		break;
-	default:
-        request->print_msg (my_table->moduleID, "ERROR");
-        fatal_error ("Client: I state shouldn't see this message\n");
-    }
-}
-
-inline void MOESIF_protocol::do_snoop_FM_Intermediate (Mreq *request)
-{
-	switch(request->msg) {
-	case GETS:
-		set_shared_line();
-		send_DATA_on_bus(request->addr,request->src_mid);
-		break;
-	case GETM:
-		send_DATA_on_bus(request->addr,request->src_mid);
-		if (request->src_mid != my_table->moduleID){
-			state = MOESIF_CACHE_IM_Intermediate;
-		}
-		break;
-	case DATA:
-	   	state = MOESIF_CACHE_M;
-	   	send_DATA_to_proc(request->addr);
-	   	break;
-	default:
-	   	request->print_msg (my_table->moduleID, "ERROR");
-       		fatal_error ("Client: SM state shouldn't see this message\n");
-    }
+const MOESIF_cache_state_t MOESIF_protocol::initial_state = MOESIF_CACHE_I;
+
+const char *const MOESIF_protocol::name = "MOESIF";
+
+/** Same size and order as the state enum in the header */
+const char *const MOESIF_protocol::state_names[MOESIF_CACHE_NUM_STATES] = {"X", "I", "S", "E", "O", "M", "MC", "F", "IS", "IM", "SM", "OM", "FM", "MI", "II"};
+
+/** Same order as state_names, true for the states that supply data as the
+ * line's owner (see supplier_of) rather than as a clean forwarder
+ */
+const bool MOESIF_protocol::owner_states[MOESIF_CACHE_NUM_STATES] = {
+    /* X */ false, /* I */ false, /* S */ false, /* E */ false, /* O */ true,
+    /* M */ true, /* MC */ true, /* F */ false, /* IS */ false, /* IM */ false,
+    /* SM */ false, /* OM */ true, /* FM */ false, /* MI */ true, /* II */ false
+};
+
+void MOESIF_protocol::dump_state (unsigned char state)
+{
+    fprintf (stderr, "MOESIF_protocol - state: %s\n", state_names[state]);
+}
+
+/** MOESIF transitions, indexed by [state][message].  Columns are in message_t order:
+ * NOP, LOAD, STORE, GETS, GETM, DATA, EVICT, PUTM, UPGRADE.  Messages left out of
+ * a row are errors.  IS also takes DATA_EXCL, the data of a migratory hand over
+ * (see migratory.h), after the unused UPDATE column.
+ * The entries in upgrade_patches are shown with UPGRADE off, see set_upgrade
+ */
+Transition MOESIF_protocol::transitions[MOESIF_CACHE_NUM_STATES][MREQ_MESSAGE_NUM] = {
+    /* X */ TRANS_ROW_INVALID,
+    /* I */ {
+        TRANS_ERROR,
+        /* LOAD    */ TRANS (ACT_SEND_GETS | ACT_CACHE_MISS, MOESIF_CACHE_IS_Intermediate),
+        /* STORE   */ TRANS (ACT_SEND_GETM | ACT_CACHE_MISS, MOESIF_CACHE_IM_Intermediate),
+        /* GETS    */ TRANS (ACT_NONE, MOESIF_CACHE_I),
+        /* GETM    */ TRANS (ACT_NONE, MOESIF_CACHE_I),
+        /* DATA    */ TRANS (ACT_NONE, MOESIF_CACHE_I),
+        /* EVICT   */ TRANS (ACT_NONE, MOESIF_CACHE_I),
+        /* PUTM    */ TRANS_ERROR,
+        /* UPGRADE */ TRANS (ACT_NONE, MOESIF_CACHE_I)
+    },
+    /* S */ {
+        TRANS_ERROR,
+        /* LOAD    */ TRANS (ACT_SEND_DATA_PROC, MOESIF_CACHE_S),
+        /* STORE   */ TRANS (ACT_SEND_GETM | ACT_CACHE_MISS, MOESIF_CACHE_IM_Intermediate),
+        /* GETS    */ TRANS (ACT_SET_SHARED, MOESIF_CACHE_S),
+        /* GETM    */ TRANS (ACT_NONE, MOESIF_CACHE_I),
+        /* DATA    */ TRANS (ACT_NONE, MOESIF_CACHE_S),
+        /* EVICT   */ TRANS (ACT_NONE, MOESIF_CACHE_I),
+        /* PUTM    */ TRANS_ERROR,
+        /* UPGRADE */ TRANS (ACT_NONE, MOESIF_CACHE_I)
+    },
+    /* E */ {
+        TRANS_ERROR,
+        /* LOAD    */ TRANS (ACT_SEND_DATA_PROC, MOESIF_CACHE_E),
+        /* STORE   */ TRANS (ACT_SEND_DATA_PROC | ACT_SILENT_UPGRADE, MOESIF_CACHE_M),
+        /* GETS    */ TRANS (ACT_SET_SHARED | ACT_SEND_DATA_BUS, MOESIF_CACHE_F),
+        /* GETM    */ TRANS (ACT_SET_SHARED | ACT_SEND_DATA_BUS, MOESIF_CACHE_I),
+        /* DATA    */ TRANS (ACT_NONE, MOESIF_CACHE_E),
+        /* EVICT   */ TRANS (ACT_NONE, MOESIF_CACHE_I),
+        /* PUTM    */ TRANS_ERROR,
+        /* UPGRADE */ TRANS (ACT_NONE, MOESIF_CACHE_E)
+    },
+    /* O */ {
+        TRANS_ERROR,
+        /* LOAD    */ TRANS (ACT_SEND_DATA_PROC, MOESIF_CACHE_O),
+        /* STORE   */ TRANS (ACT_SEND_GETM | ACT_CACHE_MISS, MOESIF_CACHE_OM_Intermediate),
+        /* GETS    */ TRANS (ACT_SET_SHARED | ACT_SEND_DATA_BUS, MOESIF_CACHE_O),
+        /* GETM    */ TRANS (ACT_SET_SHARED | ACT_SEND_DATA_BUS, MOESIF_CACHE_I),
+        /* DATA    */ TRANS (ACT_NONE, MOESIF_CACHE_O),
+        /* EVICT   */ TRANS (ACT_SEND_PUTM, MOESIF_CACHE_MI_Intermediate),
+        /* PUTM    */ TRANS_ERROR,
+        /* UPGRADE */ TRANS (ACT_NONE, MOESIF_CACHE_I)
+    },
+    /* M */ {
+        TRANS_ERROR,
+        /* LOAD    */ TRANS (ACT_SEND_DATA_PROC, MOESIF_CACHE_M),
+        /* STORE   */ TRANS (ACT_SEND_DATA_PROC, MOESIF_CACHE_M),
+        /* GETS    */ TRANS_IF_MIGRATORY (ACT_SET_SHARED | ACT_SEND_DATA_BUS, MOESIF_CACHE_I, MOESIF_CACHE_O),
+        /* GETM    */ TRANS (ACT_SET_SHARED | ACT_SEND_DATA_BUS, MOESIF_CACHE_I),
+        /* DATA    */ TRANS (ACT_NONE, MOESIF_CACHE_M),
+        /* EVICT   */ TRANS (ACT_SEND_PUTM, MOESIF_CACHE_MI_Intermediate),
+        /* PUTM    */ TRANS_ERROR,
+        /* UPGRADE */ TRANS (ACT_NONE, MOESIF_CACHE_M)
+    },
+    /* Handed over by a migratory GETS (see migratory.h) and not written yet.
+     * Dirty like M; a GETS before the write means the line isn't migratory
+     */
+    /* MC */ {
+        TRANS_ERROR,
+        /* LOAD    */ TRANS (ACT_SEND_DATA_PROC, MOESIF_CACHE_MC),
+        /* STORE   */ TRANS (ACT_SEND_DATA_PROC, MOESIF_CACHE_M),
+        /* GETS    */ TRANS (ACT_SET_SHARED | ACT_SEND_DATA_BUS | ACT_DECLASSIFY, MOESIF_CACHE_O),
+        /* GETM    */ TRANS (ACT_SET_SHARED | ACT_SEND_DATA_BUS, MOESIF_CACHE_I),
+        /* DATA    */ TRANS (ACT_NONE, MOESIF_CACHE_MC),
+        /* EVICT   */ TRANS (ACT_SEND_PUTM, MOESIF_CACHE_MI_Intermediate),
+        /* PUTM    */ TRANS_ERROR,
+        /* UPGRADE */ TRANS (ACT_NONE, MOESIF_CACHE_MC)
+    },
+    /* F */ {
+        TRANS_ERROR,
+        /* LOAD    */ TRANS (ACT_SEND_DATA_PROC, MOESIF_CACHE_F),
+        /* STORE   */ TRANS (ACT_SEND_GETM | ACT_CACHE_MISS, MOESIF_CACHE_FM_Intermediate),
+        /* GETS    */ TRANS (ACT_SET_SHARED | ACT_SEND_DATA_BUS, MOESIF_CACHE_F),
+        /* GETM    */ TRANS (ACT_SET_SHARED | ACT_SEND_DATA_BUS, MOESIF_CACHE_I),
+        /* DATA    */ TRANS_ERROR,
+        /* EVICT   */ TRANS (ACT_NONE, MOESIF_CACHE_I),
+        /* PUTM    */ TRANS_ERROR,
+        /* UPGRADE */ TRANS (ACT_NONE, MOESIF_CACHE_I)
+    },
+    /* IS */ {
+        TRANS_ERROR,
+        /* LOAD    */ TRANS (ACT_NONE, MOESIF_CACHE_IS_Intermediate),
+        /* STORE   */ TRANS (ACT_NONE, MOESIF_CACHE_IS_Intermediate),
+        /* GETS    */ TRANS (ACT_NONE, MOESIF_CACHE_IS_Intermediate),
+        /* GETM    */ TRANS (ACT_NONE, MOESIF_CACHE_IS_Intermediate),
+        /* DATA    */ TRANS_IF_SHARED (ACT_SEND_DATA_PROC, MOESIF_CACHE_S, MOESIF_CACHE_E),
+        /* EVICT   */ TRANS_ERROR,
+        /* PUTM    */ TRANS_ERROR,
+        /* UPGRADE */ TRANS (ACT_NONE, MOESIF_CACHE_IS_Intermediate),
+        /* UPDATE  */ TRANS_ERROR,
+        /* DATA_EXCL */ TRANS (ACT_SEND_DATA_PROC, MOESIF_CACHE_MC)
+    },
+    /* IM */ {
+        TRANS_ERROR,
+        /* LOAD    */ TRANS (ACT_NONE, MOESIF_CACHE_IM_Intermediate),
+        /* STORE   */ TRANS (ACT_NONE, MOESIF_CACHE_IM_Intermediate),
+        /* GETS    */ TRANS (ACT_NONE, MOESIF_CACHE_IM_Intermediate),
+        /* GETM    */ TRANS (ACT_NONE, MOESIF_CACHE_IM_Intermediate),
+        /* DATA    */ TRANS (ACT_SEND_DATA_PROC, MOESIF_CACHE_M),
+        /* EVICT   */ TRANS_ERROR,
+        /* PUTM    */ TRANS_ERROR,
+        /* UPGRADE */ TRANS_IF_OWN (ACT_SEND_GETM, MOESIF_CACHE_IM_Intermediate, MOESIF_CACHE_IM_Intermediate)
+    },
+    /* SM */ {
+        TRANS_ERROR,
+        /* LOAD    */ TRANS (ACT_NONE, MOESIF_CACHE_SM_Intermediate),
+        /* STORE   */ TRANS (ACT_NONE, MOESIF_CACHE_SM_Intermediate),
+        /* GETS    */ TRANS_IF_OTHER (ACT_SET_SHARED, MOESIF_CACHE_IM_Intermediate, MOESIF_CACHE_SM_Intermediate),
+        /* GETM    */ TRANS_IF_OTHER (ACT_NONE, MOESIF_CACHE_IM_Intermediate, MOESIF_CACHE_SM_Intermediate),
+        /* DATA    */ TRANS (ACT_SEND_DATA_PROC, MOESIF_CACHE_M),
+        /* EVICT   */ TRANS_ERROR,
+        /* PUTM    */ TRANS_ERROR,
+        /* UPGRADE */ TRANS_IF_OWN (ACT_SEND_DATA_PROC | ACT_DATA_SAVED, MOESIF_CACHE_M, MOESIF_CACHE_IM_Intermediate)
+    },
+    /* OM */ {
+        TRANS_ERROR,
+        /* LOAD    */ TRANS (ACT_NONE, MOESIF_CACHE_OM_Intermediate),
+        /* STORE   */ TRANS (ACT_NONE, MOESIF_CACHE_OM_Intermediate),
+        /* GETS    */ TRANS (ACT_SET_SHARED | ACT_SEND_DATA_BUS, MOESIF_CACHE_OM_Intermediate),
+        /* GETM    */ TRANS (ACT_SEND_DATA_BUS, MOESIF_CACHE_IM_Intermediate),
+        /* DATA    */ TRANS (ACT_NONE, MOESIF_CACHE_M),
+        /* EVICT   */ TRANS_ERROR,
+        /* PUTM    */ TRANS_ERROR,
+        /* UPGRADE */ TRANS_IF_OWN (ACT_SEND_DATA_PROC | ACT_DATA_SAVED, MOESIF_CACHE_M, MOESIF_CACHE_IM_Intermediate)
+    },
+    /* FM */ {
+        TRANS_ERROR,
+        /* LOAD    */ TRANS (ACT_NONE, MOESIF_CACHE_FM_Intermediate),
+        /* STORE   */ TRANS (ACT_NONE, MOESIF_CACHE_FM_Intermediate),
+        /* GETS    */ TRANS (ACT_SET_SHARED | ACT_SEND_DATA_BUS, MOESIF_CACHE_FM_Intermediate),
+        /* GETM    */ TRANS_IF_OTHER (ACT_SEND_DATA_BUS, MOESIF_CACHE_IM_Intermediate, MOESIF_CACHE_FM_Intermediate),
+        /* DATA    */ TRANS (ACT_SEND_DATA_PROC, MOESIF_CACHE_M),
+        /* EVICT   */ TRANS_ERROR,
+        /* PUTM    */ TRANS_ERROR,
+        /* UPGRADE */ TRANS_IF_OWN (ACT_SEND_DATA_PROC | ACT_DATA_SAVED, MOESIF_CACHE_M, MOESIF_CACHE_IM_Intermediate)
+    },
+    /* Evicted dirty line waiting for its PUTM to go out on the bus.  Until then
+     * memory is stale, so we keep supplying the data
+     */
+    /* MI */ {
+        TRANS_ERROR,
+        /* LOAD    */ TRANS_ERROR,
+        /* STORE   */ TRANS_ERROR,
+        /* GETS    */ TRANS (ACT_SET_SHARED | ACT_SEND_DATA_BUS, MOESIF_CACHE_MI_Intermediate),
+        /* GETM    */ TRANS (ACT_SET_SHARED | ACT_SEND_DATA_BUS, MOESIF_CACHE_II_Intermediate),
+        /* DATA    */ TRANS (ACT_NONE, MOESIF_CACHE_MI_Intermediate),
+        /* EVICT   */ TRANS_ERROR,
+        /* PUTM    */ TRANS (ACT_NONE, MOESIF_CACHE_I),
+        /* UPGRADE */ TRANS (ACT_NONE, MOESIF_CACHE_II_Intermediate)
+    },
+    /* Someone took the line before our PUTM went out, it carries stale data */
+    /* II */ {
+        TRANS_ERROR,
+        /* LOAD    */ TRANS_ERROR,
+        /* STORE   */ TRANS_ERROR,
+        /* GETS    */ TRANS (ACT_NONE, MOESIF_CACHE_II_Intermediate),
+        /* GETM    */ TRANS (ACT_NONE, MOESIF_CACHE_II_Intermediate),
+        /* DATA    */ TRANS (ACT_NONE, MOESIF_CACHE_II_Intermediate),
+        /* EVICT   */ TRANS_ERROR,
+        /* PUTM    */ TRANS (ACT_NONE, MOESIF_CACHE_I),
+        /* UPGRADE */ TRANS (ACT_NONE, MOESIF_CACHE_II_Intermediate)
+    }
+};
+
+/** The entries set_upgrade rewrites, off (GETM and DATA, as in the validation
+ * runs) and on (UPGRADE)
+ */
+static const Transition_patch upgrade_patches[] = {
+    { MOESIF_CACHE_S, STORE,
+      TRANS (ACT_SEND_GETM | ACT_CACHE_MISS, MOESIF_CACHE_IM_Intermediate),
+      TRANS (ACT_SEND_UPGRADE | ACT_CACHE_MISS, MOESIF_CACHE_SM_Intermediate) },
+    { MOESIF_CACHE_O, STORE,
+      TRANS (ACT_SEND_GETM | ACT_CACHE_MISS, MOESIF_CACHE_OM_Intermediate),
+      TRANS (ACT_SEND_UPGRADE | ACT_CACHE_MISS, MOESIF_CACHE_OM_Intermediate) },
+    { MOESIF_CACHE_F, STORE,
+      TRANS (ACT_SEND_GETM | ACT_CACHE_MISS, MOESIF_CACHE_FM_Intermediate),
+      TRANS (ACT_SEND_UPGRADE | ACT_CACHE_MISS, MOESIF_CACHE_FM_Intermediate) },
+    { MOESIF_CACHE_SM_Intermediate, GETS,
+      TRANS_IF_OTHER (ACT_SET_SHARED, MOESIF_CACHE_IM_Intermediate, MOESIF_CACHE_SM_Intermediate),
+      TRANS (ACT_SET_SHARED, MOESIF_CACHE_SM_Intermediate) },
+    { MOESIF_CACHE_SM_Intermediate, DATA,
+      TRANS (ACT_SEND_DATA_PROC, MOESIF_CACHE_M),
+      TRANS_ERROR },
+    { MOESIF_CACHE_OM_Intermediate, DATA,
+      TRANS (ACT_NONE, MOESIF_CACHE_M),
+      TRANS_ERROR },
+    { MOESIF_CACHE_FM_Intermediate, DATA,
+      TRANS (ACT_SEND_DATA_PROC, MOESIF_CACHE_M),
+      TRANS_ERROR },
+    { 0 }
+};
+
+void MOESIF_protocol::set_upgrade (bool upgrade)
+{
+    patch_transitions (upgrade_patches, upgrade);
 }
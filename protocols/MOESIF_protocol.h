@@ -5,7 +5,7 @@
 #include "../sim/enums.h"
 #include "../sim/module.h"
 #include "../sim/mreq.h"
-#include "protocol.h"
+#include "protocol_template.h"
 
 /**
 * author: Sahil Gupta
@@ -19,6 +19,7 @@ typedef enum {
     MOESIF_CACHE_E,
     MOESIF_CACHE_O,
     MOESIF_CACHE_M,
+    MOESIF_CACHE_MC,
     MOESIF_CACHE_F,
     
     //All the intermediate states added here
@@ -26,40 +27,43 @@ typedef enum {
     MOESIF_CACHE_IM_Intermediate,
     MOESIF_CACHE_SM_Intermediate,
     MOESIF_CACHE_OM_Intermediate,
-    MOESIF_CACHE_FM_Intermediate
+    MOESIF_CACHE_FM_Intermediate,
+    MOESIF_CACHE_MI_Intermediate,
+    MOESIF_CACHE_II_Intermediate,
+    MOESIF_CACHE_NUM_STATES
 } MOESIF_cache_state_t;
 
-class MOESIF_protocol : public Protocol {
+class MOESIF_protocol : public Protocol_template<MOESIF_protocol> {
 public:
+    typedef MOESIF_cache_state_t state_t;
+
     MOESIF_protocol (Hash_table *my_table, Hash_entry *my_entry);
     ~MOESIF_protocol ();
 
     MOESIF_cache_state_t state;
     
-    void process_cache_request (Mreq *request);
-    void process_snoop_request (Mreq *request);
-    void dump (void);
+    /** Prints a state the way dump() does, for lines kept in a Cache_array */
+    static void dump_state (unsigned char state);
+
+    /** Makes a store to a line held in S, O or F send UPGRADE instead of GETM and
+     * complete without a data transfer.  Off by default, which matches the
+     * validation runs.  Rewrites the table, so call it before the simulation
+     * starts.
+     */
+    static void set_upgrade (bool upgrade);
 
-    inline void do_cache_F (Mreq *request);
-    inline void do_cache_I (Mreq *request);
-    inline void do_cache_S (Mreq *request);
-    inline void do_cache_E (Mreq *request);
-    inline void do_cache_O (Mreq *request);
-    inline void do_cache_M (Mreq *request);
+    /** State every line starts in */
+    static const state_t initial_state;
 
-    inline void do_snoop_F (Mreq *request);
-    inline void do_snoop_I (Mreq *request);
-    inline void do_snoop_S (Mreq *request);
-    inline void do_snoop_E (Mreq *request);
-    inline void do_snoop_O (Mreq *request);
-    inline void do_snoop_M (Mreq *request);
+    static const char *const name;
+    static const char *const state_names[MOESIF_CACHE_NUM_STATES];
+    /** Dirty states, which supply data as the owner */
+    static const bool owner_states[MOESIF_CACHE_NUM_STATES];
 
-    //snooping for all the intermediate states.
-    inline void do_snoop_IS_Intermediate (Mreq *request);
-    inline void do_snoop_IM_Intermediate (Mreq *request);
-    inline void do_snoop_SM_Intermediate (Mreq *request);
-    inline void do_snoop_OM_Intermediate (Mreq *request);
-    inline void do_snoop_FM_Intermediate (Mreq *request);
+    /** Actions and next state for each [state][message], see transition_table.h.
+     * Not const, set_upgrade patches the UPGRADE entries.
+     */
+    static Transition transitions[MOESIF_CACHE_NUM_STATES][MREQ_MESSAGE_NUM];
 };
 
 #endif // _MOESIF_CACHE_H
@@ -5,7 +5,7 @@
 #include "../sim/enums.h"
 #include "../sim/module.h"
 #include "../sim/mreq.h"
-#include "protocol.h"
+#include "protocol_template.h"
 
 /**
 * author: Sahil Gupta
@@ -19,42 +19,49 @@ typedef enum {
     MOESI_CACHE_E,
     MOESI_CACHE_O,
     MOESI_CACHE_M,
+    MOESI_CACHE_MC,
     
     //All the intermediate states added here
     MOESI_CACHE_IS_Intermediate,
     MOESI_CACHE_IM_Intermediate,
     MOESI_CACHE_SM_Intermediate,
     MOESI_CACHE_OM_Intermediate,
+    MOESI_CACHE_MI_Intermediate,
+    MOESI_CACHE_II_Intermediate,
+    MOESI_CACHE_NUM_STATES
 } MOESI_cache_state_t;
 
-class MOESI_protocol : public Protocol {
+class MOESI_protocol : public Protocol_template<MOESI_protocol> {
 public:
+    typedef MOESI_cache_state_t state_t;
+
     MOESI_protocol (Hash_table *my_table, Hash_entry *my_entry);
     ~MOESI_protocol ();
 
     MOESI_cache_state_t state;
     
-    void process_cache_request (Mreq *request);
-    void process_snoop_request (Mreq *request);
-    void dump (void);
-
-    inline void do_cache_I (Mreq *request);
-    inline void do_cache_S (Mreq *request);
-    inline void do_cache_E (Mreq *request);
-    inline void do_cache_O (Mreq *request);
-    inline void do_cache_M (Mreq *request);
-
-    inline void do_snoop_I (Mreq *request);
-    inline void do_snoop_S (Mreq *request);
-    inline void do_snoop_E (Mreq *request);
-    inline void do_snoop_O (Mreq *request);
-    inline void do_snoop_M (Mreq *request);
-    
-    //snooping for all the intermediate states.
-    inline void do_snoop_IS_Intermediate (Mreq *request);
-    inline void do_snoop_IM_Intermediate (Mreq *request);
-    inline void do_snoop_SM_Intermediate (Mreq *request);
-    inline void do_snoop_OM_Intermediate (Mreq *request);
+    /** Prints a state the way dump() does, for lines kept in a Cache_array */
+    static void dump_state (unsigned char state);
+
+    /** Makes a store to a line held in S or O send UPGRADE instead of GETM and
+     * complete without a data transfer.  Off by default, which matches the
+     * validation runs.  Rewrites the table, so call it before the simulation
+     * starts.
+     */
+    static void set_upgrade (bool upgrade);
+
+    /** State every line starts in */
+    static const state_t initial_state;
+
+    static const char *const name;
+    static const char *const state_names[MOESI_CACHE_NUM_STATES];
+    /** Dirty states, which supply data as the owner */
+    static const bool owner_states[MOESI_CACHE_NUM_STATES];
+
+    /** Actions and next state for each [state][message], see transition_table.h.
+     * Not const, set_upgrade patches the UPGRADE entries.
+     */
+    static Transition transitions[MOESI_CACHE_NUM_STATES][MREQ_MESSAGE_NUM];
 };
 
 #endif // _MOESI_CACHE_H
@@ -14,208 +14,154 @@ extern Simulator *Sim;
  * Constructor/Destructor.
  *************************/
 MSI_protocol::MSI_protocol (Hash_table *my_table, Hash_entry *my_entry)
-    : Protocol (my_table, my_entry)
+    : Protocol_template<MSI_protocol> (my_table, my_entry)
 {
     // Initialize lines to not have the data yet!
-    this->state = MSI_CACHE_I;
+    this->state = initial_state;
 }
 
 MSI_protocol::~MSI_protocol ()
 {    
 }
 
-void MSI_protocol::dump (void)
-{
-    const char *block_states[7] = {"X","I","S","M", "IS", "SM", "IM"};
-    fprintf (stderr, "MSI_protocol - state: %s\n", block_states[state]);
-}
-
-void MSI_protocol::process_cache_request (Mreq *request)
-{
-	switch (state) {
-    case MSI_CACHE_I:  do_cache_I (request); break;
-    case MSI_CACHE_S:  do_cache_S (request); break;
-    case MSI_CACHE_M:  do_cache_M (request); break;
-    case MSI_CACHE_IM_Intermediate: break;
-    case MSI_CACHE_IS_Intermediate: break;
-    case MSI_CACHE_SM_Intermediate: break;
-    default:
-        fatal_error ("Invalid Cache State for MSI Protocol\n");
-        break;
-    }
-}
-
-void MSI_protocol::process_snoop_request (Mreq *request)
-{
-	switch (state) {
-    case MSI_CACHE_I:  do_snoop_I (request); break;
-    case MSI_CACHE_S:  do_snoop_S (request); break;
-    case MSI_CACHE_M:  do_snoop_M (request); break;
-    case MSI_CACHE_IS_Intermediate:  do_snoop_IS_Intermediate (request); break;
-    case MSI_CACHE_IM_Intermediate:  do_snoop_IM_Intermediate (request); break;
-    case MSI_CACHE_SM_Intermediate:  do_snoop_SM_Intermediate (request); break;
-    default:
-    	fatal_error ("Invalid Cache State for MSI Protocol\n");
-    }
-}
-
-inline void MSI_protocol::do_cache_I (Mreq *request)
-{
-    switch (request->msg) {
-    case LOAD:
-    	//this will lead to a cache miss
-    	//get the data first from the memory with the intent to share
-        send_GETS(request->addr);
-        state = MSI_CACHE_IS_Intermediate;
-        Sim->cache_misses++;
-        break;
-    case STORE:
-    	//this will lead to a cache miss
-    	//get the data first from the memory with the intent to modify
-        send_GETM(request->addr);
-        state = MSI_CACHE_IM_Intermediate;
-        Sim->cache_misses++;
-        break;
-    default:
-        request->print_msg (my_table->moduleID, "ERROR");
-        fatal_error ("Client: I state shouldn't see this message\n");
-    }
-}
-
-inline void MSI_protocol::do_cache_S (Mreq *request)
-{
-    switch (request->msg) {
-    case LOAD:
-    	//data is clean and can be sent to the processor
-        send_DATA_to_proc(request->addr);
-        break;
-    case STORE:
-    	//put the request on the bus for block with the intent to modify
-        send_GETM(request->addr);
-        state = MSI_CACHE_SM_Intermediate;
-        //Coherence miss
-        Sim->cache_misses++;
-        break;
-    default:
-        request->print_msg (my_table->moduleID, "ERROR");
-        fatal_error ("Client: I state shouldn't see this message\n");
-    }
-}
-
-inline void MSI_protocol::do_cache_M (Mreq *request)
-{
-    switch (request->msg) {
-    case LOAD:
-    case STORE:
-		//send the data to processor
-        send_DATA_to_proc(request->addr);
-        break;
-    default:
-        request->print_msg (my_table->moduleID, "ERROR");
-        fatal_error ("Client: I state shouldn't see this message\n");
-    }
+const MSI_cache_state_t MSI_protocol::initial_state = MSI_CACHE_I;
 
-}
+const char *const MSI_protocol::name = "MSI";
 
-inline void MSI_protocol::do_snoop_I (Mreq *request)
-{
-    /**
-    * If we snoop a message from another cache and we are in I, then we don't
-    * need to do anything!  We obviously cannot supply data since we don't have
-    * it, and we don't need to downgrade our state since we are already in I.
-    */
-    switch (request->msg) {
-    case GETS: break;
-    case GETM: break;
-    case DATA: break;
-    default:
-        request->print_msg (my_table->moduleID, "ERROR");
-        fatal_error ("Client: I state shouldn't see this message\n");
-    }
-}
+/** Same size and order as the state enum in the header */
+const char *const MSI_protocol::state_names[MSI_CACHE_NUM_STATES] = {"X","I","S","M", "IS", "SM", "IM", "MI", "II"};
 
-inline void MSI_protocol::do_snoop_S (Mreq *request)
-{
-    switch (request->msg) {
-    case GETS: break;
-    case GETM:
-    	//the data need to become invalid because the data has been modified
-        state = MSI_CACHE_I;
-        break;
-    case DATA: break;
-    default:
-        request->print_msg (my_table->moduleID, "ERROR");
-        fatal_error ("Client: I state shouldn't see this message\n");
-    }
-}
+/** Same order as state_names, true for the states that supply data as the
+ * line's owner (see supplier_of) rather than as a clean forwarder
+ */
+const bool MSI_protocol::owner_states[MSI_CACHE_NUM_STATES] = {
+    /* X */ false, /* I */ false, /* S */ false, /* M */ true, /* IS */ false,
+    /* SM */ false, /* IM */ false, /* MI */ true, /* II */ false
+};
 
-inline void MSI_protocol::do_snoop_M (Mreq *request)
+void MSI_protocol::dump_state (unsigned char state)
 {
-    switch (request->msg) {
-    case GETS:
-    	//since I have the most updated data, I should supply it!
-        set_shared_line();
-        send_DATA_on_bus(request->addr,request->src_mid);
-        state = MSI_CACHE_S;
-        break;
-    case GETM:
-    	//since someone else is modifying the data, I should abort and invalidate myself
-        set_shared_line();
-        send_DATA_on_bus(request->addr,request->src_mid);
-        state = MSI_CACHE_I;
-        break;
-    case DATA: break;
-    default:
-        request->print_msg (my_table->moduleID, "ERROR");
-        fatal_error ("Client: I state shouldn't see this message\n");
-    }
-
+    fprintf (stderr, "MSI_protocol - state: %s\n", state_names[state]);
 }
 
-//just supply the data
-inline void MSI_protocol::do_snoop_IS_Intermediate (Mreq *request)
-{
-    switch (request->msg) {
-    case GETS: break;
-    case GETM: break;
-    case DATA:
-        state = MSI_CACHE_S;
-        send_DATA_to_proc(request->addr);
-        break;
-    default:
-        request->print_msg (my_table->moduleID, "ERROR");
-        fatal_error ("Client: I state shouldn't see this message\n");
+/** MSI transitions, indexed by [state][message].  Columns are in message_t order:
+ * NOP, LOAD, STORE, GETS, GETM, DATA, EVICT, PUTM, UPGRADE.  Messages left out of
+ * a row are errors.
+ * The entries in upgrade_patches are shown with UPGRADE off, see set_upgrade
+ */
+Transition MSI_protocol::transitions[MSI_CACHE_NUM_STATES][MREQ_MESSAGE_NUM] = {
+    /* X */ TRANS_ROW_INVALID,
+    /* I */ {
+        TRANS_ERROR,
+        /* LOAD    */ TRANS (ACT_SEND_GETS | ACT_CACHE_MISS, MSI_CACHE_IS_Intermediate),
+        /* STORE   */ TRANS (ACT_SEND_GETM | ACT_CACHE_MISS, MSI_CACHE_IM_Intermediate),
+        /* GETS    */ TRANS (ACT_NONE, MSI_CACHE_I),
+        /* GETM    */ TRANS (ACT_NONE, MSI_CACHE_I),
+        /* DATA    */ TRANS (ACT_NONE, MSI_CACHE_I),
+        /* EVICT   */ TRANS (ACT_NONE, MSI_CACHE_I),
+        /* PUTM    */ TRANS_ERROR,
+        /* UPGRADE */ TRANS (ACT_NONE, MSI_CACHE_I)
+    },
+    /* S */ {
+        TRANS_ERROR,
+        /* LOAD    */ TRANS (ACT_SEND_DATA_PROC, MSI_CACHE_S),
+        /* STORE   */ TRANS (ACT_SEND_GETM | ACT_CACHE_MISS, MSI_CACHE_SM_Intermediate),
+        /* GETS    */ TRANS (ACT_NONE, MSI_CACHE_S),
+        /* GETM    */ TRANS (ACT_NONE, MSI_CACHE_I),
+        /* DATA    */ TRANS (ACT_NONE, MSI_CACHE_S),
+        /* EVICT   */ TRANS (ACT_NONE, MSI_CACHE_I),
+        /* PUTM    */ TRANS_ERROR,
+        /* UPGRADE */ TRANS (ACT_NONE, MSI_CACHE_I)
+    },
+    /* M */ {
+        TRANS_ERROR,
+        /* LOAD    */ TRANS (ACT_SEND_DATA_PROC, MSI_CACHE_M),
+        /* STORE   */ TRANS (ACT_SEND_DATA_PROC, MSI_CACHE_M),
+        /* GETS    */ TRANS (ACT_SET_SHARED | ACT_SEND_DATA_BUS, MSI_CACHE_S),
+        /* GETM    */ TRANS (ACT_SET_SHARED | ACT_SEND_DATA_BUS, MSI_CACHE_I),
+        /* DATA    */ TRANS (ACT_NONE, MSI_CACHE_M),
+        /* EVICT   */ TRANS (ACT_SEND_PUTM, MSI_CACHE_MI_Intermediate),
+        /* PUTM    */ TRANS_ERROR,
+        /* UPGRADE */ TRANS (ACT_NONE, MSI_CACHE_M)
+    },
+    /* IS */ {
+        TRANS_ERROR,
+        /* LOAD    */ TRANS (ACT_NONE, MSI_CACHE_IS_Intermediate),
+        /* STORE   */ TRANS (ACT_NONE, MSI_CACHE_IS_Intermediate),
+        /* GETS    */ TRANS (ACT_NONE, MSI_CACHE_IS_Intermediate),
+        /* GETM    */ TRANS (ACT_NONE, MSI_CACHE_IS_Intermediate),
+        /* DATA    */ TRANS (ACT_SEND_DATA_PROC, MSI_CACHE_S),
+        /* EVICT   */ TRANS_ERROR,
+        /* PUTM    */ TRANS_ERROR,
+        /* UPGRADE */ TRANS (ACT_NONE, MSI_CACHE_IS_Intermediate)
+    },
+    /* SM */ {
+        TRANS_ERROR,
+        /* LOAD    */ TRANS (ACT_NONE, MSI_CACHE_SM_Intermediate),
+        /* STORE   */ TRANS (ACT_NONE, MSI_CACHE_SM_Intermediate),
+        /* GETS    */ TRANS (ACT_NONE, MSI_CACHE_SM_Intermediate),
+        /* GETM    */ TRANS (ACT_NONE, MSI_CACHE_SM_Intermediate),
+        /* DATA    */ TRANS (ACT_SEND_DATA_PROC, MSI_CACHE_M),
+        /* EVICT   */ TRANS_ERROR,
+        /* PUTM    */ TRANS_ERROR,
+        /* UPGRADE */ TRANS_IF_OWN (ACT_SEND_DATA_PROC | ACT_DATA_SAVED, MSI_CACHE_M, MSI_CACHE_IM_Intermediate)
+    },
+    /* IM */ {
+        TRANS_ERROR,
+        /* LOAD    */ TRANS (ACT_NONE, MSI_CACHE_IM_Intermediate),
+        /* STORE   */ TRANS (ACT_NONE, MSI_CACHE_IM_Intermediate),
+        /* GETS    */ TRANS (ACT_NONE, MSI_CACHE_IM_Intermediate),
+        /* GETM    */ TRANS (ACT_NONE, MSI_CACHE_IM_Intermediate),
+        /* DATA    */ TRANS (ACT_SEND_DATA_PROC, MSI_CACHE_M),
+        /* EVICT   */ TRANS_ERROR,
+        /* PUTM    */ TRANS_ERROR,
+        /* UPGRADE */ TRANS_IF_OWN (ACT_SEND_GETM, MSI_CACHE_IM_Intermediate, MSI_CACHE_IM_Intermediate)
+    },
+    /* Evicted dirty line waiting for its PUTM to go out on the bus.  Until then
+     * memory is stale, so we keep supplying the data
+     */
+    /* MI */ {
+        TRANS_ERROR,
+        /* LOAD    */ TRANS_ERROR,
+        /* STORE   */ TRANS_ERROR,
+        /* GETS    */ TRANS (ACT_SET_SHARED | ACT_SEND_DATA_BUS, MSI_CACHE_MI_Intermediate),
+        /* GETM    */ TRANS (ACT_SET_SHARED | ACT_SEND_DATA_BUS, MSI_CACHE_II_Intermediate),
+        /* DATA    */ TRANS (ACT_NONE, MSI_CACHE_MI_Intermediate),
+        /* EVICT   */ TRANS_ERROR,
+        /* PUTM    */ TRANS (ACT_NONE, MSI_CACHE_I),
+        /* UPGRADE */ TRANS (ACT_NONE, MSI_CACHE_MI_Intermediate)
+    },
+    /* Someone took the line before our PUTM went out, it carries stale data */
+    /* II */ {
+        TRANS_ERROR,
+        /* LOAD    */ TRANS_ERROR,
+        /* STORE   */ TRANS_ERROR,
+        /* GETS    */ TRANS (ACT_NONE, MSI_CACHE_II_Intermediate),
+        /* GETM    */ TRANS (ACT_NONE, MSI_CACHE_II_Intermediate),
+        /* DATA    */ TRANS (ACT_NONE, MSI_CACHE_II_Intermediate),
+        /* EVICT   */ TRANS_ERROR,
+        /* PUTM    */ TRANS (ACT_NONE, MSI_CACHE_I),
+        /* UPGRADE */ TRANS (ACT_NONE, MSI_CACHE_II_Intermediate)
     }
-}
-
-//just supply the data
-inline void MSI_protocol::do_snoop_IM_Intermediate (Mreq *request)
+};
+
+/** The entries set_upgrade rewrites, off (GETM and DATA, as in the validation
+ * runs) and on (UPGRADE)
+ */
+static const Transition_patch upgrade_patches[] = {
+    { MSI_CACHE_S, STORE,
+      TRANS (ACT_SEND_GETM | ACT_CACHE_MISS, MSI_CACHE_SM_Intermediate),
+      TRANS (ACT_SEND_UPGRADE | ACT_CACHE_MISS, MSI_CACHE_SM_Intermediate) },
+    { MSI_CACHE_SM_Intermediate, GETM,
+      TRANS (ACT_NONE, MSI_CACHE_SM_Intermediate),
+      TRANS_IF_OTHER (ACT_NONE, MSI_CACHE_IM_Intermediate, MSI_CACHE_SM_Intermediate) },
+    { MSI_CACHE_SM_Intermediate, DATA,
+      TRANS (ACT_SEND_DATA_PROC, MSI_CACHE_M),
+      TRANS_ERROR },
+    { 0 }
+};
+
+void MSI_protocol::set_upgrade (bool upgrade)
 {
-    switch (request->msg) {
-    case GETS: break;
-    case GETM: break;
-    case DATA:
-        state = MSI_CACHE_M;
-        send_DATA_to_proc(request->addr);
-        break;
-    default:
-        request->print_msg (my_table->moduleID, "ERROR");
-        fatal_error ("Client: I state shouldn't see this message\n");
-    }
-}
-
-//just supply the data
-inline void MSI_protocol::do_snoop_SM_Intermediate (Mreq *request)
-{
-    switch (request->msg) {
-    case GETS: break;
-    case GETM: break;
-    case DATA:
-        state = MSI_CACHE_M;
-        send_DATA_to_proc(request->addr);
-        break;
-    default:
-        request->print_msg (my_table->moduleID, "ERROR");
-        fatal_error ("Client: I state shouldn't see this message\n");
-    }
+    patch_transitions (upgrade_patches, upgrade);
 }
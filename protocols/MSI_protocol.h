@@ -5,7 +5,7 @@
 #include "../sim/enums.h"
 #include "../sim/module.h"
 #include "../sim/mreq.h"
-#include "protocol.h"
+#include "protocol_template.h"
 
 /**
 * author: Sahil Gupta
@@ -20,39 +20,44 @@ typedef enum {
     //Intermediate states which have been added
     MSI_CACHE_IS_Intermediate,
     MSI_CACHE_SM_Intermediate,
-    MSI_CACHE_IM_Intermediate
+    MSI_CACHE_IM_Intermediate,
+    MSI_CACHE_MI_Intermediate,
+    MSI_CACHE_II_Intermediate,
+    MSI_CACHE_NUM_STATES
 } MSI_cache_state_t;
 
-class MSI_protocol : public Protocol {
+class MSI_protocol : public Protocol_template<MSI_protocol> {
 public:
+    typedef MSI_cache_state_t state_t;
+
     MSI_protocol (Hash_table *my_table, Hash_entry *my_entry);
     ~MSI_protocol ();
 
     // Cache state for this line
     MSI_cache_state_t state;
     
-    void process_cache_request (Mreq *request);
-    void process_snoop_request (Mreq *request);
-    void dump (void);
+    /** Prints a state the way dump() does, for lines kept in a Cache_array */
+    static void dump_state (unsigned char state);
 
-    /* Functions that specify the actions to take on requests from the processor
-     * when the cache is in various states
+    /** Makes a store to a line held in S send UPGRADE instead of GETM and
+     * complete without a data transfer.  Off by default, which matches the
+     * validation runs.  Rewrites the table, so call it before the simulation
+     * starts.
      */
-    inline void do_cache_I (Mreq *request);
-    inline void do_cache_S (Mreq * request);
-    inline void do_cache_M (Mreq *request);
+    static void set_upgrade (bool upgrade);
+
+    /** State every line starts in */
+    static const state_t initial_state;
+
+    static const char *const name;
+    static const char *const state_names[MSI_CACHE_NUM_STATES];
+    /** Dirty states, which supply data as the owner */
+    static const bool owner_states[MSI_CACHE_NUM_STATES];
 
-    /* Functions that specify the actions to take on snooped requests
-     * when the cache is in various states
+    /** Actions and next state for each [state][message], see transition_table.h.
+     * Not const, set_upgrade patches the UPGRADE entries.
      */
-    inline void do_snoop_I (Mreq *request);
-    inline void do_snoop_S (Mreq * request);
-    inline void do_snoop_M (Mreq *request);
-    
-    //Intermediate states which have been added
-    inline void do_snoop_IS_Intermediate (Mreq *request);
-    inline void do_snoop_SM_Intermediate (Mreq *request);
-    inline void do_snoop_IM_Intermediate (Mreq *request);
+    static Transition transitions[MSI_CACHE_NUM_STATES][MREQ_MESSAGE_NUM];
 };
 
 #endif // _MSI_CACHE_H
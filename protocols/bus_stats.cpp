@@ -0,0 +1,161 @@
+#include <string.h>
+#include "bus_stats.h"
+#include "../sim/sim.h"
+
+Bus_accounting Bus_usage;
+
+Bus_accounting::Bus_accounting ()
+{
+    enabled = false;
+    line_size = 64;
+    address_bytes = 8;
+    word_bytes = 8;
+    bus_width = 8;
+    window = 10000;
+    busy_cycles = 0;
+    queue_cycles = 0;
+    max_queue_delay = 0;
+    memset (messages, 0, sizeof (messages));
+    memset (bytes_sent, 0, sizeof (bytes_sent));
+}
+
+unsigned int Bus_accounting::bytes (message_t msg)
+{
+    switch (msg) {
+    case DATA:
+    case DATA_EXCL:
+    case PUTM:
+        return address_bytes + line_size;
+    case UPDATE:
+        return address_bytes + word_bytes;
+    default:
+        return address_bytes;
+    }
+}
+
+Bus_accounting::Source_slots &Bus_accounting::slots_of (ModuleID source)
+{
+    for (unsigned int i = 0; i < sources.size (); i++)
+        if (sources[i].source == source)
+            return sources[i];
+
+    Source_slots empty;
+    empty.source = source;
+    for (int s = 0; s < BUS_QUEUE_SLOTS; s++)
+        empty.slots[s].request = NULL;
+    empty.next = 0;
+    sources.push_back (empty);
+    return sources.back ();
+}
+
+void Bus_accounting::enqueue (ModuleID source, Mreq *request, unsigned long long now)
+{
+    Source_slots &q = slots_of (source);
+
+    /* A recycled message may still have the slot of its last life */
+    for (int s = 0; s < BUS_QUEUE_SLOTS; s++)
+        if (q.slots[s].request == request) {
+            q.slots[s].queued_at = now;
+            return;
+        }
+    q.slots[q.next].request = request;
+    q.slots[q.next].queued_at = now;
+    q.next = (q.next + 1) % BUS_QUEUE_SLOTS;
+}
+
+unsigned int Bus_accounting::granted (ModuleID source, Mreq *request, unsigned long long now)
+{
+    unsigned int size = bytes (request->msg);
+    unsigned int cycles = (size + bus_width - 1) / bus_width;
+
+    if (!enabled)
+        return cycles;
+
+    messages[request->msg]++;
+    bytes_sent[request->msg] += size;
+    busy_cycles += cycles;
+
+    Source_slots &q = slots_of (source);
+    for (int s = 0; s < BUS_QUEUE_SLOTS; s++) {
+        if (q.slots[s].request != request)
+            continue;
+        unsigned long long delay = now - q.slots[s].queued_at;
+        queue_cycles += delay;
+        if (delay > max_queue_delay)
+            max_queue_delay = delay;
+        q.slots[s].request = NULL;
+        break;
+    }
+
+    /* Spread the transfer over the windows it falls into */
+    unsigned long long start = now, end = now + cycles;
+    while (start < end) {
+        unsigned long long w = start / window;
+        unsigned long long stop = (w + 1) * window < end ? (w + 1) * window : end;
+        if (w >= window_busy.size ())
+            window_busy.resize (w + 1, 0);
+        window_busy[w] += stop - start;
+        start = stop;
+    }
+    return cycles;
+}
+
+void Bus_accounting::dump_stats ()
+{
+    unsigned long long total_bytes = 0, total_messages = 0, peak = 0;
+
+    if (!enabled)
+        return;
+
+    for (int m = 0; m < MREQ_MESSAGE_NUM; m++) {
+        total_bytes += bytes_sent[m];
+        total_messages += messages[m];
+    }
+    for (unsigned int w = 0; w < window_busy.size (); w++)
+        if (window_busy[w] > peak)
+            peak = window_busy[w];
+
+    fprintf (stderr, "Bus messages: %llu\n", total_messages);
+    fprintf (stderr, "Bus bytes: %llu\n", total_bytes);
+    fprintf (stderr, "Bus busy cycles: %llu (%.1f%% of %llu)\n", busy_cycles,
+             Global_Clock ? 100.0 * busy_cycles / Global_Clock : 0.0, (unsigned long long) Global_Clock);
+    fprintf (stderr, "Bus peak utilization: %.1f%% over %llu cycle windows\n",
+             100.0 * peak / window, window);
+    fprintf (stderr, "Bus queueing delay: %.2f cycles average, %llu max\n",
+             total_messages ? (double) queue_cycles / total_messages : 0.0, max_queue_delay);
+}
+
+void Bus_accounting::write_json (FILE *f)
+{
+    fprintf (f, "  \"bus\": {\n");
+    fprintf (f, "      \"enabled\": %s,\n", enabled ? "true" : "false");
+    fprintf (f, "      \"busy_cycles\": %llu,\n", busy_cycles);
+    fprintf (f, "      \"queue_cycles\": %llu,\n", queue_cycles);
+    fprintf (f, "      \"max_queue_delay\": %llu,\n", max_queue_delay);
+    fprintf (f, "      \"messages\": {");
+    for (int m = 0; m < MREQ_MESSAGE_NUM; m++)
+        fprintf (f, "%s\"%s\": %llu", m ? ", " : "", Mreq::message_t_str[m], messages[m]);
+    fprintf (f, "},\n");
+    fprintf (f, "      \"bytes\": {");
+    for (int m = 0; m < MREQ_MESSAGE_NUM; m++)
+        fprintf (f, "%s\"%s\": %llu", m ? ", " : "", Mreq::message_t_str[m], bytes_sent[m]);
+    fprintf (f, "},\n");
+    fprintf (f, "      \"window\": %llu,\n", window);
+    fprintf (f, "      \"utilization\": [");
+    for (unsigned int w = 0; w < window_busy.size (); w++)
+        fprintf (f, "%s%.4f", w ? ", " : "", (double) window_busy[w] / window);
+    fprintf (f, "]\n  },\n");
+}
+
+void Bus_accounting::write_csv (FILE *f)
+{
+    fprintf (f, "bus,busy_cycles,,%llu\n", busy_cycles);
+    fprintf (f, "bus,queue_cycles,,%llu\n", queue_cycles);
+    fprintf (f, "bus,max_queue_delay,,%llu\n", max_queue_delay);
+    for (int m = 0; m < MREQ_MESSAGE_NUM; m++)
+        fprintf (f, "bus,messages,%s,%llu\n", Mreq::message_t_str[m], messages[m]);
+    for (int m = 0; m < MREQ_MESSAGE_NUM; m++)
+        fprintf (f, "bus,bytes,%s,%llu\n", Mreq::message_t_str[m], bytes_sent[m]);
+    for (unsigned int w = 0; w < window_busy.size (); w++)
+        fprintf (f, "bus,window_busy,%u,%llu\n", w, window_busy[w]);
+}
@@ -0,0 +1,104 @@
+#ifndef BUS_STATS_H_
+#define BUS_STATS_H_
+
+#include <stdio.h>
+#include <vector>
+#include "../sim/types.h"
+#include "../sim/module.h"
+#include "../sim/mreq.h"
+#include "messages.h"
+
+/** Messages per source whose queueing delay is tracked at once */
+#define BUS_QUEUE_SLOTS 8
+
+/** Bandwidth and occupancy accounting for the bus (or the directory's
+ * interconnect).
+ *
+ * Every message is sized as address_bytes of address and command, plus a
+ * line for DATA, DATA_EXCL and the PUTM writeback, or a word for UPDATE.  It
+ * holds the bus for bytes / bus_width cycles (at least one).  The Protocol::send_* helpers and
+ * the directory call queued() when they hand a message to write_to_bus, and
+ * the bus calls queued() for what the memory controller sends.  The bus
+ * calls granted() when a message wins arbitration and uses the returned
+ * transfer time.  Both name the module that queued the message, since a
+ * directory's forwarded request carries the requester as its src_mid.
+ *
+ * The queueing delay is kept in BUS_QUEUE_SLOTS slots per source, so nothing
+ * is allocated per message.  A message granted without a slot (never queued,
+ * or pushed out by BUS_QUEUE_SLOTS newer ones from the same source) is still
+ * counted, just without a queueing delay.
+ *
+ * Busy cycles are also kept per window of window cycles, which gives the
+ * utilization over time.  Set the widths before the first message.
+ */
+class Bus_accounting
+{
+public:
+    Bus_accounting ();
+
+    /** Off by default; queued() and granted() then only size the transfer */
+    bool enabled;
+
+    unsigned int line_size;
+    unsigned int address_bytes;
+    unsigned int word_bytes;
+    /** Bytes the bus moves per cycle */
+    unsigned int bus_width;
+    /** Cycles per utilization window */
+    unsigned long long window;
+
+    /** Size of a msg on the bus */
+    unsigned int bytes (message_t msg);
+
+    /** source put request in the arbitration queue */
+    inline void queued (ModuleID source, Mreq *request, unsigned long long now)
+    {
+        if (enabled)
+            enqueue (source, request, now);
+    }
+    /** The bus picked request, queued by source.  Returns the cycles the
+     * transfer holds the bus
+     */
+    unsigned int granted (ModuleID source, Mreq *request, unsigned long long now);
+
+    unsigned long long messages[MREQ_MESSAGE_NUM];
+    unsigned long long bytes_sent[MREQ_MESSAGE_NUM];
+    unsigned long long busy_cycles;
+    /** Cycles granted messages spent in the arbitration queue */
+    unsigned long long queue_cycles;
+    unsigned long long max_queue_delay;
+    /** Busy cycles of each window, [i] covers [i * window, (i + 1) * window) */
+    std::vector<unsigned long long> window_busy;
+
+    void dump_stats ();
+    /** Writes "bus": {...} for the Stats export */
+    void write_json (FILE *f);
+    void write_csv (FILE *f);
+
+private:
+    struct Queue_slot
+    {
+        /** NULL if free */
+        Mreq *request;
+        unsigned long long queued_at;
+    };
+
+    struct Source_slots
+    {
+        ModuleID source;
+        /** Filled round robin, the oldest is reused once all are taken */
+        Queue_slot slots[BUS_QUEUE_SLOTS];
+        unsigned int next;
+    };
+
+    /** One entry per module that ever queued a message */
+    std::vector<Source_slots> sources;
+
+    void enqueue (ModuleID source, Mreq *request, unsigned long long now);
+    Source_slots &slots_of (ModuleID source);
+};
+
+/** There is one bus */
+extern Bus_accounting Bus_usage;
+
+#endif /* BUS_STATS_H_ */
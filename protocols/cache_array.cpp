@@ -0,0 +1,91 @@
+#include "cache_array.h"
+
+Cache_array::Cache_array (const Cache_config &config, unsigned char initial_state,
+                          bool (*can_evict) (unsigned char state))
+    : assoc (config.assoc), line_size (config.line_size),
+      initial_state (initial_state), can_evict (can_evict), allowed (config.assoc)
+{
+    if (config.assoc == 0 || config.line_size == 0 || (config.line_size & (config.line_size - 1)))
+        fatal_error ("Invalid cache geometry\n");
+    num_sets = config.size / (config.assoc * config.line_size);
+    if (num_sets == 0 || (num_sets & (num_sets - 1)))
+        fatal_error ("Cache must have a power of two number of sets\n");
+
+    Line empty = {0, initial_state, false, false};
+    lines.resize (num_sets * assoc, empty);
+    policy = Replacement_policy::create (config.replacement, num_sets, assoc);
+}
+
+Cache_array::~Cache_array ()
+{
+    delete policy;
+}
+
+Cache_array::Line *Cache_array::lookup (paddr_t addr)
+{
+    paddr_t line = line_addr (addr);
+    Line *set = &lines[set_of (addr) * assoc];
+
+    for (unsigned int w = 0; w < assoc; w++)
+        if (set[w].valid && set[w].addr == line)
+            return &set[w];
+    return NULL;
+}
+
+Cache_array::Line *Cache_array::lookup_any (paddr_t addr)
+{
+    Line *line = lookup (addr);
+    if (line || writebacks.empty ())
+        return line;
+
+    std::map<paddr_t, Line>::iterator it = writebacks.find (line_addr (addr));
+    return it == writebacks.end () ? NULL : &it->second;
+}
+
+void Cache_array::touch (Line *line)
+{
+    unsigned int index = line - &lines[0];
+    policy->touch (index / assoc, index % assoc);
+}
+
+Cache_array::Line *Cache_array::victim (paddr_t addr)
+{
+    unsigned int s = set_of (addr);
+    Line *set = &lines[s * assoc];
+
+    /* Free ways and lines that are already in I cost nothing */
+    for (unsigned int w = 0; w < assoc; w++)
+        if (!set[w].valid)
+            return &set[w];
+    for (unsigned int w = 0; w < assoc; w++)
+        if (set[w].state == initial_state)
+            return &set[w];
+
+    for (unsigned int w = 0; w < assoc; w++)
+        allowed[w] = can_evict (set[w].state);
+    int w = policy->victim (s, allowed);
+    return w < 0 ? NULL : &set[w];
+}
+
+void Cache_array::hold (Line *line)
+{
+    writebacks[line->addr] = *line;
+    line->valid = false;
+}
+
+Cache_array::Line *Cache_array::fill (Line *way, paddr_t addr)
+{
+    unsigned int index = way - &lines[0];
+
+    way->addr = line_addr (addr);
+    way->state = initial_state;
+    way->valid = true;
+    way->invalidate_pending = false;
+    policy->insert (index / assoc, index % assoc);
+    return way;
+}
+
+void Cache_array::release (Line *line)
+{
+    writebacks.erase (line->addr);
+}
@@ -0,0 +1,93 @@
+#ifndef CACHE_ARRAY_H_
+#define CACHE_ARRAY_H_
+
+#include <map>
+#include <vector>
+#include "../sim/types.h"
+#include "replacement.h"
+
+typedef struct {
+    /** Capacity in bytes */
+    unsigned int size;
+    unsigned int assoc;
+    /** Bytes per line, a power of two */
+    unsigned int line_size;
+    replacement_t replacement;
+} Cache_config;
+
+/** Set-associative, capacity-limited storage for the coherence state of one
+ * cache's lines.
+ *
+ * Protocol_template::cache_request (Cache_array &, Mreq *) and snoop_request
+ * (Cache_array &, Mreq *) drive it: a miss picks a victim with the replacement
+ * policy and runs an EVICT through the protocol for it before the new line is
+ * filled.  A victim that still has a writeback in flight (it left the initial
+ * state for MI/II) moves to a small writeback buffer, where snoops still find
+ * it, until the protocol brings it back to I.
+ *
+ * Lines are only chosen as victims if the protocol's table handles EVICT in
+ * their state, which keeps lines with a request in flight resident.  The same
+ * holds for back-invalidation, which marks such a line and evicts it once
+ * its request is done.
+ */
+class Cache_array
+{
+public:
+    struct Line
+    {
+        paddr_t addr;
+        unsigned char state;
+        bool valid;
+        /** Back-invalidated while a request was in flight, see Protocol_template::back_invalidate */
+        bool invalidate_pending;
+    };
+
+    Cache_array (const Cache_config &config, unsigned char initial_state,
+                 bool (*can_evict) (unsigned char state));
+    ~Cache_array ();
+
+    paddr_t line_addr (paddr_t addr) const { return addr & ~(paddr_t) (line_size - 1); }
+
+    /** Line holding addr in the array, NULL on a miss */
+    Line *lookup (paddr_t addr);
+    /** Same, but also looks in the writeback buffer */
+    Line *lookup_any (paddr_t addr);
+
+    void touch (Line *line);
+
+    /** Way addr's line should go in, NULL if no way of the set can be evicted
+     * right now.  The way may still hold a valid line that has to be evicted
+     */
+    Line *victim (paddr_t addr);
+    /** Moves a victim that is still writing back into the writeback buffer */
+    void hold (Line *line);
+    /** Puts addr's line into way in the initial state */
+    Line *fill (Line *way, paddr_t addr);
+    /** Drops a writeback buffer entry that is back in the initial state */
+    void release (Line *line);
+
+    bool in_array (const Line *line) const
+    {
+        return line >= &lines[0] && line < &lines[0] + lines.size ();
+    }
+
+    unsigned int num_sets;
+    unsigned int assoc;
+    unsigned int line_size;
+
+private:
+    std::vector<Line> lines;
+    Replacement_policy *policy;
+    std::map<paddr_t, Line> writebacks;
+    unsigned char initial_state;
+    bool (*can_evict) (unsigned char state);
+    /** Scratch space for victim() */
+    std::vector<bool> allowed;
+
+    unsigned int set_of (paddr_t addr) const
+    {
+        return (unsigned int) (addr / line_size) & (num_sets - 1);
+    }
+};
+
+#endif /* CACHE_ARRAY_H_ */
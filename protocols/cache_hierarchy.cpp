@@ -0,0 +1,154 @@
+#include "cache_hierarchy.h"
+#include "stats.h"
+
+Cache_hierarchy::Cache_hierarchy (const Hierarchy_config &config, int num_cores)
+    : l2_hits (0), llc_hits (0), memory_reads (0), memory_writebacks (0), back_invalidations (0),
+      config (config), num_cores (num_cores)
+{
+    if (config.l2_enabled)
+        for (int i = 0; i < num_cores; i++)
+            l2s.push_back (new Cache_array (config.l2, LEVEL_I, can_evict));
+    llc = new Cache_array (config.llc, LEVEL_I, can_evict);
+}
+
+Cache_hierarchy::~Cache_hierarchy ()
+{
+    for (unsigned int i = 0; i < l2s.size (); i++)
+        delete l2s[i];
+    delete llc;
+}
+
+Cache_array::Line *Cache_hierarchy::present (Cache_array *array, paddr_t addr)
+{
+    Cache_array::Line *line = array->lookup (addr);
+    return (line && line->state != LEVEL_I) ? line : NULL;
+}
+
+int Cache_hierarchy::fill (int core, paddr_t addr)
+{
+    Cache_array *l2 = config.l2_enabled ? l2s[core] : NULL;
+    Cache_array::Line *line;
+
+    if (l2 && (line = present (l2, addr))) {
+        l2_hits++;
+        Stats.core (core).l2_hits++;
+        l2->touch (line);
+        return config.l2_latency;
+    }
+
+    int latency;
+    unsigned char state = LEVEL_CLEAN;
+    if ((line = present (llc, addr))) {
+        llc_hits++;
+        Stats.core (core).llc_hits++;
+        latency = config.llc_latency;
+        if (config.inclusion == HIER_EXCLUSIVE && l2) {
+            /* Moves up, the dirty data goes with it */
+            state = line->state;
+            line->state = LEVEL_I;
+        } else {
+            llc->touch (line);
+        }
+    } else {
+        memory_reads++;
+        Stats.core (core).memory_fills++;
+        latency = config.mem_latency;
+        if (config.inclusion != HIER_EXCLUSIVE || !l2)
+            install (llc, -1, addr, LEVEL_CLEAN);
+    }
+
+    if (l2)
+        install (l2, core, addr, state);
+    return latency;
+}
+
+void Cache_hierarchy::writeback (int core, paddr_t addr)
+{
+    Cache_array *target = config.l2_enabled ? l2s[core] : llc;
+    Cache_array::Line *line = present (target, addr);
+
+    if (line)
+        line->state = LEVEL_DIRTY;
+    else
+        install (target, config.l2_enabled ? core : -1, addr, LEVEL_DIRTY);
+}
+
+Cache_array::Line *Cache_hierarchy::install (Cache_array *array, int core, paddr_t addr, unsigned char state)
+{
+    Cache_array::Line *line = present (array, addr);
+
+    if (!line) {
+        line = array->victim (addr);
+        if (line->valid && line->state != LEVEL_I) {
+            Cache_array::Line victim = *line;
+            /* Free the way first, evicted() may install into another level */
+            line->state = LEVEL_I;
+            evicted (array, core, victim);
+        }
+        line = array->fill (line, addr);
+    }
+    if (state == LEVEL_DIRTY || line->state == LEVEL_I)
+        line->state = state;
+    array->touch (line);
+    return line;
+}
+
+/** core is -1 for the LLC */
+void Cache_hierarchy::evicted (Cache_array *array, int core, const Cache_array::Line &victim)
+{
+    if (array == llc) {
+        if (victim.state == LEVEL_DIRTY)
+            memory_writebacks++;
+        if (config.inclusion != HIER_INCLUSIVE)
+            return;
+        for (int c = 0; c < num_cores; c++) {
+            if (config.l2_enabled) {
+                Cache_array::Line *line = present (l2s[c], victim.addr);
+                if (line) {
+                    /* The L2 copy is the newest, write it through to memory */
+                    if (line->state == LEVEL_DIRTY)
+                        memory_writebacks++;
+                    line->state = LEVEL_I;
+                }
+            }
+            if (back_invalidate (c, victim.addr)) {
+                back_invalidations++;
+                Stats.core (c).back_invalidations++;
+            }
+        }
+        return;
+    }
+
+    /* Private L2 victim */
+    switch (config.inclusion) {
+    case HIER_INCLUSIVE:
+        if (victim.state == LEVEL_DIRTY) {
+            Cache_array::Line *line = present (llc, victim.addr);
+            if (line)
+                line->state = LEVEL_DIRTY;
+            else
+                install (llc, -1, victim.addr, LEVEL_DIRTY);
+        }
+        if (back_invalidate (core, victim.addr)) {
+            back_invalidations++;
+            Stats.core (core).back_invalidations++;
+        }
+        break;
+    case HIER_NON_INCLUSIVE:
+        if (victim.state == LEVEL_DIRTY)
+            install (llc, -1, victim.addr, LEVEL_DIRTY);
+        break;
+    case HIER_EXCLUSIVE:
+        install (llc, -1, victim.addr, victim.state);
+        break;
+    }
+}
+
+void Cache_hierarchy::dump_stats ()
+{
+    fprintf (stderr, "Hierarchy L2 hits: %llu\n", l2_hits);
+    fprintf (stderr, "Hierarchy LLC hits: %llu\n", llc_hits);
+    fprintf (stderr, "Hierarchy memory reads: %llu\n", memory_reads);
+    fprintf (stderr, "Hierarchy memory writebacks: %llu\n", memory_writebacks);
+    fprintf (stderr, "Hierarchy back-invalidations: %llu\n", back_invalidations);
+}
@@ -0,0 +1,89 @@
+#ifndef CACHE_HIERARCHY_H_
+#define CACHE_HIERARCHY_H_
+
+#include <vector>
+#include "../sim/types.h"
+#include "cache_array.h"
+
+typedef enum {
+    HIER_INCLUSIVE = 0,	// LLC holds everything above it, its victims are back-invalidated
+    HIER_NON_INCLUSIVE,	// Fills go everywhere, victims are just dropped
+    HIER_EXCLUSIVE		// LLC only holds L2 victims (a victim cache)
+} inclusion_t;
+
+typedef struct {
+    /** Private L2 per core, or none if l2_enabled is false */
+    bool l2_enabled;
+    Cache_config l2;
+    int l2_latency;
+    /** Shared last level cache */
+    Cache_config llc;
+    int llc_latency;
+    int mem_latency;
+    inclusion_t inclusion;
+} Hierarchy_config;
+
+/** Private L2s and a shared LLC between the snooping L1s and memory.
+ *
+ * Only requests no L1 supplies reach the hierarchy: the memory controller
+ * calls fill() for every GETS/GETM it answers and uses the returned latency
+ * instead of its fixed one, and hands every PUTM to writeback().  The levels
+ * only track presence and dirtiness, the L1 protocols are untouched.
+ *
+ * With HIER_INCLUSIVE an LLC victim is removed from every L2 and an L2 victim
+ * from its L1, through back_invalidate(), which the simulator implements by
+ * running Protocol_template::back_invalidate on the L1's Cache_array.  That
+ * evicts the line like a replacement would (M/O lines write back with PUTM).
+ * An L1 line with a request in flight is evicted as soon as the request
+ * completes.  Only L1s that held the line count a back-invalidation.  The
+ * PUTMs back-invalidation causes reach
+ * writeback() through the bus as usual, never from inside back_invalidate().
+ */
+class Cache_hierarchy
+{
+public:
+    Cache_hierarchy (const Hierarchy_config &config, int num_cores);
+    virtual ~Cache_hierarchy ();
+
+    /** Drops core's L1 copy of addr, implemented by the simulator.  Returns
+     * false if the L1 didn't hold the line
+     */
+    virtual bool back_invalidate (int core, paddr_t addr) =0;
+
+    /** An L1 miss of core was not supplied by another cache.  Returns the
+     * cycles until the data is there
+     */
+    int fill (int core, paddr_t addr);
+    /** core's L1 wrote addr back */
+    void writeback (int core, paddr_t addr);
+
+    unsigned long long l2_hits;
+    unsigned long long llc_hits;
+    unsigned long long memory_reads;
+    unsigned long long memory_writebacks;
+    unsigned long long back_invalidations;
+
+    void dump_stats ();
+
+private:
+    typedef enum {
+        LEVEL_I = 1,
+        LEVEL_CLEAN,
+        LEVEL_DIRTY
+    } level_state_t;
+
+    Hierarchy_config config;
+    int num_cores;
+    std::vector<Cache_array *> l2s;
+    Cache_array *llc;
+
+    static bool can_evict (unsigned char state) { return true; }
+
+    /** Line holding addr in array, NULL if it isn't there (or is in I) */
+    static Cache_array::Line *present (Cache_array *array, paddr_t addr);
+    /** Puts addr into array in state, handling the victim, and returns its line */
+    Cache_array::Line *install (Cache_array *array, int core, paddr_t addr, unsigned char state);
+    void evicted (Cache_array *array, int core, const Cache_array::Line &victim);
+};
+
+#endif /* CACHE_HIERARCHY_H_ */
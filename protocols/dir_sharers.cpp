@@ -0,0 +1,84 @@
+#include "dir_sharers.h"
+
+#define BITS_PER_WORD (8 * sizeof (unsigned long))
+
+Dir_sharers::Dir_sharers (sharer_kind_t kind, int num_cores, int max_pointers)
+    : kind (kind), overflow (false), num_cores (num_cores), max_pointers (max_pointers)
+{
+    if (kind == SHARERS_FULL_MAP)
+        bits.resize ((num_cores + BITS_PER_WORD - 1) / BITS_PER_WORD, 0);
+}
+
+void Dir_sharers::add (int core)
+{
+    if (kind == SHARERS_FULL_MAP) {
+        bits[core / BITS_PER_WORD] |= 1UL << (core % BITS_PER_WORD);
+        return;
+    }
+
+    if (overflow || contains (core))
+        return;
+    if ((int) pointers.size () < max_pointers) {
+        pointers.push_back (core);
+    } else {
+        /* Out of pointers, from now on every core is a potential sharer */
+        pointers.clear ();
+        overflow = true;
+    }
+}
+
+void Dir_sharers::remove (int core)
+{
+    if (kind == SHARERS_FULL_MAP) {
+        bits[core / BITS_PER_WORD] &= ~(1UL << (core % BITS_PER_WORD));
+        return;
+    }
+
+    for (unsigned int i = 0; i < pointers.size (); i++) {
+        if (pointers[i] == core) {
+            pointers.erase (pointers.begin () + i);
+            return;
+        }
+    }
+}
+
+void Dir_sharers::clear ()
+{
+    for (unsigned int i = 0; i < bits.size (); i++)
+        bits[i] = 0;
+    pointers.clear ();
+    overflow = false;
+}
+
+bool Dir_sharers::contains (int core) const
+{
+    if (kind == SHARERS_FULL_MAP)
+        return (bits[core / BITS_PER_WORD] >> (core % BITS_PER_WORD)) & 1;
+
+    for (unsigned int i = 0; i < pointers.size (); i++)
+        if (pointers[i] == core)
+            return true;
+    return false;
+}
+
+bool Dir_sharers::empty () const
+{
+    for (unsigned int i = 0; i < bits.size (); i++)
+        if (bits[i])
+            return false;
+    return pointers.empty () && !overflow;
+}
+
+void Dir_sharers::get (std::vector<int> &cores) const
+{
+    if (overflow) {
+        for (int i = 0; i < num_cores; i++)
+            cores.push_back (i);
+    } else if (kind == SHARERS_FULL_MAP) {
+        for (int i = 0; i < num_cores; i++)
+            if (contains (i))
+                cores.push_back (i);
+    } else {
+        cores.insert (cores.end (), pointers.begin (), pointers.end ());
+    }
+}
@@ -0,0 +1,49 @@
+#ifndef DIR_SHARERS_H_
+#define DIR_SHARERS_H_
+
+#include <vector>
+
+/** How a directory entry remembers which caches hold a line */
+typedef enum {
+    SHARERS_FULL_MAP = 0,	// One bit per core
+    SHARERS_LIMITED_PTR		// A few core ids, broadcast once they run out
+} sharer_kind_t;
+
+/** Sharer set of one directory entry.
+ *
+ * The full bit-vector is exact but costs num_cores bits per line.  The
+ * limited-pointer version (Dir_i_B) keeps up to max_pointers core ids; adding
+ * one more sets the overflow flag, after which the set no longer knows who the
+ * sharers are and get() returns every core, so invalidations are broadcast.
+ */
+class Dir_sharers
+{
+public:
+    Dir_sharers (sharer_kind_t kind, int num_cores, int max_pointers);
+
+    void add (int core);
+    /** No effect once a limited-pointer set has overflowed */
+    void remove (int core);
+    void clear ();
+
+    /** True only if core is known to be a sharer, so false for an overflowed set */
+    bool contains (int core) const;
+    bool overflowed () const { return overflow; }
+    bool empty () const;
+
+    /** Appends the cores that have to be invalidated to cores */
+    void get (std::vector<int> &cores) const;
+
+private:
+    unsigned char kind;
+    bool overflow;
+    int num_cores;
+    int max_pointers;
+
+    /** SHARERS_FULL_MAP */
+    std::vector<unsigned long> bits;
+    /** SHARERS_LIMITED_PTR */
+    std::vector<int> pointers;
+};
+
+#endif /* DIR_SHARERS_H_ */
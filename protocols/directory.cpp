@@ -0,0 +1,265 @@
+#include "directory.h"
+#include "mreq_pool.h"
+#include "bus_stats.h"
+#include "trace_log.h"
+
+Directory_controller::Dir_entry::Dir_entry (sharer_kind_t kind, int num_cores, int max_pointers)
+    : state (DIR_I), busy (false), owner (-1), sharers (kind, num_cores, max_pointers),
+      acks_pending (0), reply (NOP), reply_from_memory (false)
+{
+}
+
+Directory_controller::Directory_controller (ModuleID id, const std::vector<ModuleID> &caches,
+                                            sharer_kind_t kind, int max_pointers,
+                                            int mem_latency, bool exclusive_grant)
+    : moduleID (id), requests (0), forwards (0), invalidations (0), broadcasts (0),
+      memory_reads (0), upgrades (0), writebacks (0), deferred_requests (0),
+      caches (caches), kind (kind), max_pointers (max_pointers),
+      mem_latency (mem_latency), exclusive_grant (exclusive_grant)
+{
+}
+
+Directory_controller::~Directory_controller ()
+{
+}
+
+Directory_controller::Dir_entry &Directory_controller::lookup (paddr_t addr)
+{
+    std::map<paddr_t, Dir_entry>::iterator it = entries.find (addr);
+    if (it == entries.end ())
+        it = entries.insert (std::make_pair (addr, Dir_entry (kind, caches.size (), max_pointers))).first;
+    return it->second;
+}
+
+int Directory_controller::core_of (ModuleID mid)
+{
+    if (mid.nodeID < 0 || mid.nodeID >= (int) caches.size ())
+        Trace_log::fatal ("Directory: request from unknown node %d\n", mid.nodeID);
+    return mid.nodeID;
+}
+
+void Directory_controller::process_request (Mreq *request)
+{
+    paddr_t addr = request->addr;
+    Dir_entry &e = lookup (addr);
+    Dir_request r;
+
+    switch (request->msg) {
+    case GETS:
+    case GETM:
+    case UPGRADE:
+    case PUTM:
+        requests++;
+        r.msg = request->msg;
+        r.core = core_of (request->src_mid);
+        r.src_mid = request->src_mid;
+        if (e.busy) {
+            e.waiting.push_back (r);
+            deferred_requests++;
+        } else {
+            start (request->addr, e, r);
+        }
+        break;
+    case DATA:
+        /* The owner answered a FWD_GETS by keeping a clean copy */
+        if (!e.busy || e.current.msg != GETS || e.owner < 0)
+            Trace_log::fatal ("Directory: unexpected DATA\n");
+        writebacks++;
+        e.sharers.add (e.owner);
+        e.owner = -1;
+        e.state = DIR_S;
+        ack (request->addr, e);
+        break;
+    case INV_ACK:
+        if (!e.busy || e.acks_pending == 0)
+            Trace_log::fatal ("Directory: unexpected INV_ACK\n");
+        /* The owner answered a FWD_GETS by keeping the line dirty */
+        if (e.current.msg == GETS)
+            e.state = DIR_O;
+        ack (request->addr, e);
+        break;
+    default:
+        request->print_msg (moduleID, "ERROR");
+        Trace_log::fatal ("Directory: shouldn't see this message\n");
+    }
+
+    if (Mreq_allocator.consumers_release)
+        Mreq_allocator.release (request);
+    drain (addr, e);
+}
+
+void Directory_controller::handle_event (void *arg)
+{
+    Mreq *reply = (Mreq *) arg;
+    paddr_t addr = reply->addr;
+
+    Bus_usage.queued (moduleID, reply, Global_Clock);
+    send (reply);
+    Dir_entry &e = lookup (addr);
+    e.busy = false;
+    drain (addr, e);
+}
+
+/** Starts the requests that queued up behind the one that just finished */
+void Directory_controller::drain (paddr_t addr, Dir_entry &e)
+{
+    while (!e.busy && !e.waiting.empty ()) {
+        Dir_request r = e.waiting.front ();
+        e.waiting.pop_front ();
+        start (addr, e, r);
+    }
+}
+
+void Directory_controller::start (paddr_t addr, Dir_entry &e, const Dir_request &r)
+{
+    e.busy = true;
+    e.current = r;
+    e.acks_pending = 0;
+    e.reply = NOP;
+    e.reply_from_memory = true;
+
+    if (r.msg == PUTM) {
+        /* A PUTM that lost the race against a forwarded request is stale: the
+         * sender gave the line up in the meantime and only needs the ack
+         */
+        if (e.owner == r.core) {
+            writebacks++;
+            e.owner = -1;
+            e.state = (e.state == DIR_O && !e.sharers.empty ()) ? DIR_S : DIR_I;
+        }
+        send_to (PUT_ACK, addr, moduleID, r.src_mid);
+        e.busy = false;
+        return;
+    }
+
+    if (r.msg == GETS) {
+        switch (e.state) {
+        case DIR_I:
+            if (exclusive_grant) {
+                e.reply = DATA_EXCL;
+                e.state = DIR_M;
+                e.owner = r.core;
+                break;
+            }
+            /* Fall through */
+        case DIR_S:
+            e.reply = DATA;
+            e.state = DIR_S;
+            e.sharers.add (r.core);
+            break;
+        case DIR_M:
+        case DIR_O:
+            if (e.owner == r.core)
+                Trace_log::fatal ("Directory: GETS from the owner\n");
+            /* The owner's DATA or INV_ACK decides between S and O */
+            send_to (FWD_GETS, addr, r.src_mid, caches[e.owner]);
+            forwards++;
+            e.acks_pending = 1;
+            e.sharers.add (r.core);
+            break;
+        }
+    } else {
+        switch (e.state) {
+        case DIR_I:
+            e.reply = DATA;
+            break;
+        case DIR_S:
+            /* An upgrading sharer already has the data */
+            e.reply = DATA;
+            e.reply_from_memory = !e.sharers.contains (r.core);
+            if (r.msg == UPGRADE && !e.reply_from_memory) {
+                e.reply = UPGRADE;
+                upgrades++;
+            }
+            invalidate (addr, e, r.core, -1);
+            break;
+        case DIR_M:
+        case DIR_O:
+            if (e.owner == r.core) {
+                if (e.state == DIR_M)
+                    Trace_log::fatal ("Directory: %s from the owner\n", Mreq::message_t_str[r.msg]);
+                /* O -> M upgrade, only the sharers have to go */
+                e.reply = DATA;
+                if (r.msg == UPGRADE) {
+                    e.reply = UPGRADE;
+                    upgrades++;
+                }
+                e.reply_from_memory = false;
+                invalidate (addr, e, r.core, -1);
+                break;
+            }
+            if (e.state == DIR_O)
+                invalidate (addr, e, r.core, e.owner);
+            send_to (FWD_GETM, addr, r.src_mid, caches[e.owner]);
+            forwards++;
+            e.acks_pending++;
+            break;
+        }
+        e.state = DIR_M;
+        e.owner = r.core;
+        e.sharers.clear ();
+    }
+
+    if (e.acks_pending == 0)
+        finish (addr, e);
+}
+
+void Directory_controller::ack (paddr_t addr, Dir_entry &e)
+{
+    if (--e.acks_pending == 0)
+        finish (addr, e);
+}
+
+/** Every ack is in: reply to the requester and free the line, unless the
+ * reply still has to wait for memory
+ */
+void Directory_controller::finish (paddr_t addr, Dir_entry &e)
+{
+    if (e.reply != NOP) {
+        if (e.reply_from_memory) {
+            memory_reads++;
+            if (mem_latency > 0) {
+                Mreq *reply = Mreq_allocator.alloc (e.reply, addr, moduleID, e.current.src_mid);
+                Events.schedule (Global_Clock + mem_latency, this, reply);
+                return;
+            }
+        }
+        send_to (e.reply, addr, moduleID, e.current.src_mid);
+    }
+    e.busy = false;
+}
+
+void Directory_controller::invalidate (paddr_t addr, Dir_entry &e, int except1, int except2)
+{
+    std::vector<int> cores;
+    e.sharers.get (cores);
+    if (e.sharers.overflowed ())
+        broadcasts++;
+
+    for (unsigned int i = 0; i < cores.size (); i++) {
+        if (cores[i] == except1 || cores[i] == except2)
+            continue;
+        send_to (INV, addr, moduleID, caches[cores[i]]);
+        invalidations++;
+        e.acks_pending++;
+    }
+}
+
+void Directory_controller::send_to (message_t msg, paddr_t addr, ModuleID src, ModuleID dest)
+{
+    Mreq *request = Mreq_allocator.alloc (msg, addr, src, dest);
+    Bus_usage.queued (moduleID, request, Global_Clock);
+    send (request);
+}
+
+void Directory_controller::dump_stats ()
+{
+    fprintf (stderr, "Directory requests: %llu\n", requests);
+    fprintf (stderr, "Directory forwards: %llu\n", forwards);
+    fprintf (stderr, "Directory invalidations: %llu\n", invalidations);
+    fprintf (stderr, "Directory broadcasts: %llu\n", broadcasts);
+    fprintf (stderr, "Directory memory reads: %llu\n", memory_reads);
+    fprintf (stderr, "Directory upgrades: %llu\n", upgrades);
+    fprintf (stderr, "Directory writebacks: %llu\n", writebacks);
+    fprintf (stderr, "Directory deferred requests: %llu\n", deferred_requests);
+}
@@ -0,0 +1,126 @@
+#ifndef DIRECTORY_H_
+#define DIRECTORY_H_
+
+#include <deque>
+#include <map>
+#include <vector>
+#include "../sim/types.h"
+#include "../sim/module.h"
+#include "../sim/mreq.h"
+#include "dir_sharers.h"
+#include "event_queue.h"
+
+/** Home directory for the DIR_* protocols.
+ *
+ * Instead of broadcasting GETS/GETM to every cache, the L1s send them to the
+ * directory (see Protocol::use_directory), which forwards them point-to-point:
+ *
+ *     FWD_GETS/FWD_GETM  to the owner, with src_mid set to the requester so the
+ *                        owner sends DATA straight to it.  The owner then tells
+ *                        the directory it is done with DATA (it kept a clean
+ *                        S copy and wrote the line back) or INV_ACK (it gave the
+ *                        line up, or kept it in O).
+ *     INV                to each sharer, answered with INV_ACK.
+ *     DATA/DATA_EXCL     from memory, mem_latency cycles after the request.  The
+ *                        reply is an event on Events, see event_queue.h.
+ *     PUT_ACK            to a cache that wrote a replaced line back with PUTM.
+ *     UPGRADE            to a requester that still holds the data (a sharer, or
+ *                        the owner in O) instead of DATA.  An UPGRADE from a
+ *                        cache that lost its copy in the meantime is handled
+ *                        like a GETM.
+ *
+ * The directory is blocking: a line stays busy from the request until every ack
+ * is in and the reply has been sent, and requests that arrive for a busy line
+ * wait in order.  Acks are collected here rather than at the requester, so the
+ * requester only ever waits for one DATA.  Like the bus, the interconnect must
+ * deliver messages in the order they are sent.
+ */
+class Directory_controller : public Event_handler
+{
+public:
+    /** caches[i] is the ModuleID of core i's L1.  When exclusive_grant is set
+     * (DIR_MESI) a GETS for an uncached line is answered with DATA_EXCL.
+     */
+    Directory_controller (ModuleID id, const std::vector<ModuleID> &caches,
+                          sharer_kind_t kind, int max_pointers,
+                          int mem_latency, bool exclusive_grant);
+    virtual ~Directory_controller ();
+
+    /** Puts a message on the interconnect, implemented by the simulator */
+    virtual void send (Mreq *request) =0;
+
+    /** Handles a GETS, GETM, UPGRADE, PUTM, DATA or INV_ACK addressed to the
+     * directory.  Releases it to Mreq_allocator if consumers_release is set
+     */
+    void process_request (Mreq *request);
+    /** A memory reply is due, arg is the reply message */
+    void handle_event (void *arg);
+
+    ModuleID moduleID;
+
+    /** Counters, reported by dump_stats */
+    unsigned long long requests;
+    unsigned long long forwards;
+    unsigned long long invalidations;
+    unsigned long long broadcasts;
+    unsigned long long memory_reads;
+    unsigned long long upgrades;
+    unsigned long long writebacks;
+    unsigned long long deferred_requests;
+
+    void dump_stats ();
+
+private:
+    typedef enum {
+        DIR_I = 0,	// No cache has the line
+        DIR_S,		// Clean in the sharers, memory is up to date
+        DIR_M,		// owner has it in E or M
+        DIR_O		// owner has it dirty, sharers have clean copies
+    } dir_state_t;
+
+    struct Dir_request
+    {
+        message_t msg;
+        int core;
+        ModuleID src_mid;
+    };
+
+    struct Dir_entry
+    {
+        Dir_entry (sharer_kind_t kind, int num_cores, int max_pointers);
+
+        unsigned char state;
+        bool busy;
+        int owner;
+        Dir_sharers sharers;
+
+        /** The request being serviced while busy */
+        Dir_request current;
+        int acks_pending;
+        /** What the directory sends once the acks are in, NOP if nothing */
+        message_t reply;
+        bool reply_from_memory;
+
+        std::deque<Dir_request> waiting;
+    };
+
+    Dir_entry &lookup (paddr_t addr);
+    int core_of (ModuleID mid);
+
+    void start (paddr_t addr, Dir_entry &e, const Dir_request &r);
+    void ack (paddr_t addr, Dir_entry &e);
+    void finish (paddr_t addr, Dir_entry &e);
+    void drain (paddr_t addr, Dir_entry &e);
+    void send_to (message_t msg, paddr_t addr, ModuleID src, ModuleID dest);
+    void invalidate (paddr_t addr, Dir_entry &e, int except1, int except2);
+
+    std::vector<ModuleID> caches;
+    sharer_kind_t kind;
+    int max_pointers;
+    int mem_latency;
+    bool exclusive_grant;
+
+    std::map<paddr_t, Dir_entry> entries;
+};
+
+#endif /* DIRECTORY_H_ */
@@ -0,0 +1,36 @@
+#include "event_queue.h"
+
+Event_queue Events;
+
+Event_queue::Event_queue ()
+    : events_fired (0), cycles_skipped (0), next_seq (0)
+{
+}
+
+void Event_queue::schedule (timestamp_t when, Event_handler *handler, void *arg)
+{
+    Event e;
+    e.when = when;
+    e.seq = next_seq++;
+    e.handler = handler;
+    e.arg = arg;
+    events.push (e);
+}
+
+void Event_queue::run (timestamp_t now)
+{
+    while (!events.empty () && events.top ().when <= now) {
+        Event e = events.top ();
+        events.pop ();
+        events_fired++;
+        e.handler->handle_event (e.arg);
+    }
+}
+
+timestamp_t Event_queue::skip_target (timestamp_t now)
+{
+    if (events.empty () || events.top ().when <= now + 1)
+        return now + 1;
+    cycles_skipped += events.top ().when - now - 1;
+    return events.top ().when;
+}
@@ -0,0 +1,73 @@
+#ifndef EVENT_QUEUE_H_
+#define EVENT_QUEUE_H_
+
+#include <queue>
+#include <vector>
+#include "../sim/types.h"
+
+/** Anything that wants to be called back at a later cycle */
+class Event_handler
+{
+public:
+    virtual ~Event_handler () {}
+    virtual void handle_event (void *arg) =0;
+};
+
+/** Discrete event queue keyed on cycle.
+ *
+ * Modules that know they have nothing to do until some later cycle (e.g. a
+ * memory reply mem_latency cycles out) schedule an event instead of being
+ * polled every cycle.  The simulator's main loop calls run(Global_Clock) each
+ * cycle it simulates, and when every module is idle it calls next_time() and
+ * moves Global_Clock straight there instead of stepping through the empty
+ * cycles one by one.  Since nothing happens in the skipped cycles, the
+ * validation output is the same as stepping.
+ *
+ * Events for the same cycle fire in the order they were scheduled.
+ */
+class Event_queue
+{
+public:
+    Event_queue ();
+
+    void schedule (timestamp_t when, Event_handler *handler, void *arg);
+
+    bool empty () const { return events.empty (); }
+    /** Cycle of the earliest pending event, only valid if !empty() */
+    timestamp_t next_time () const { return events.top ().when; }
+
+    /** Fires every event due by now, including ones scheduled while firing */
+    void run (timestamp_t now);
+
+    /** Where an idle simulator at now should jump to: the next event, or now + 1
+     * if nothing is pending so the caller can decide it is done
+     */
+    timestamp_t skip_target (timestamp_t now);
+
+    unsigned long long events_fired;
+    /** Cycles jumped over by skip_target */
+    unsigned long long cycles_skipped;
+
+private:
+    struct Event
+    {
+        timestamp_t when;
+        unsigned long long seq;
+        Event_handler *handler;
+        void *arg;
+
+        /** priority_queue is a max-heap, so "less" means "fires later" */
+        bool operator< (const Event &o) const
+        {
+            return when != o.when ? when > o.when : seq > o.seq;
+        }
+    };
+
+    std::priority_queue<Event> events;
+    unsigned long long next_seq;
+};
+
+/** There is one queue for the whole simulation */
+extern Event_queue Events;
+
+#endif /* EVENT_QUEUE_H_ */
@@ -0,0 +1,17 @@
+#ifndef LINE_HASH_H_
+#define LINE_HASH_H_
+
+#include "../sim/types.h"
+
+/** Index of addr in a table of 1 << bits slots.
+ *
+ * Fibonacci hashing: the top bits of addr times 2^64 / phi, so line addresses
+ * that differ only in their low bits (neighbouring lines) still spread over
+ * the whole table.  bits must be between 1 and 32.
+ */
+inline unsigned int line_hash (paddr_t addr, unsigned int bits)
+{
+    return (unsigned int) ((addr * 0x9E3779B97F4A7C15ULL) >> (64 - bits));
+}
+
+#endif /* LINE_HASH_H_ */
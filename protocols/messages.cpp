@@ -24,5 +24,18 @@ const char * Mreq::message_t_str[MREQ_MESSAGE_NUM] = {
 
     "DATA",
 
+    "EVICT",
+    "PUTM",
+    "UPGRADE",
+
+    "UPDATE",
+
+    "DATA_EXCL",
+    "FWD_GETS",
+    "FWD_GETM",
+    "INV",
+    "INV_ACK",
+    "PUT_ACK",
+
     "MREQ_INVALID"
 };
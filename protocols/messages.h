@@ -24,6 +24,28 @@ typedef enum
 
     DATA,
 
+    /* Capacity-limited caches */
+    EVICT,			// From the cache to the protocol: this line is being replaced
+    PUTM,			// Writeback of a dirty line.  Only seen by its sender and memory
+    				// (the directory in directory mode), other caches never snoop it
+    UPGRADE,		// GETM from a cache that already holds the data (S, O or F), no
+    				// DATA follows.  A sender whose copy was taken by another GETM or
+    				// UPGRADE first asks again with GETM when its UPGRADE comes by.
+    				// The directory answers it with UPGRADE.  Only sent by protocols
+    				// whose set_upgrade is on
+
+    /* Write-update protocols */
+    UPDATE,			// A write to a shared line, broadcast so the other copies take
+    				// the new data instead of being invalidated
+
+    /* Point-to-point messages used by the directory protocols */
+    DATA_EXCL,		// DATA from the directory granting an exclusive (E) copy
+    FWD_GETS,		// GETS forwarded by the directory to the owner, src is the requester
+    FWD_GETM,		// GETM forwarded by the directory to the owner, src is the requester
+    INV,			// Invalidate a shared copy
+    INV_ACK,		// Invalidation or forward done, sent to the directory
+    PUT_ACK,		// The directory has handled a PUTM
+
     MREQ_INVALID,
 	MREQ_MESSAGE_NUM	// Use this to make a Stat Array of message types
 } message_t;
@@ -0,0 +1,82 @@
+#include "migratory.h"
+#include "stats.h"
+
+Migratory_detector Migratory_lines;
+
+Migratory_detector::Migratory_detector ()
+    : enabled (false)
+{
+    Slot empty = {0, NOBODY, NOBODY, false, false};
+    for (unsigned int i = 0; i < (1 << MIGRATORY_TABLE_BITS); i++)
+        slots[i] = empty;
+}
+
+void Migratory_detector::hand_over (paddr_t addr, ModuleID src)
+{
+    if (!enabled)
+        return;
+
+    Slot &s = lookup (addr);
+    s.writer = src.nodeID;
+    s.reader = NOBODY;
+}
+
+void Migratory_detector::observe (message_t msg, paddr_t addr, ModuleID src)
+{
+    if (!enabled)
+        return;
+
+    Slot &s = lookup (addr);
+    int core = src.nodeID;
+
+    switch (msg) {
+    case GETS:
+        /* After a hand over to core, writer is already core */
+        if (s.writer != core)
+            s.reader = (s.reader == NOBODY || s.reader == core) ? core : (int) MANY;
+        break;
+    case GETM:
+    case UPGRADE:
+        if (s.reader == MANY) {
+            s.migratory = false;
+        } else if (s.reader == core && s.writer != core && !s.migratory) {
+            s.migratory = true;
+            Stats.core (core).migrations_detected++;
+        }
+        s.writer = core;
+        s.reader = NOBODY;
+        break;
+    default:
+        break;
+    }
+}
+
+void Migratory_detector::declassify (paddr_t addr, int core)
+{
+    if (!enabled)
+        return;
+
+    Slot &s = slots[line_hash (addr, MIGRATORY_TABLE_BITS)];
+    if (!s.used || s.addr != addr)
+        return;
+    if (s.migratory) {
+        s.migratory = false;
+        Stats.core (core).migratory_declassified++;
+    }
+    /* core read the line and never wrote it, like any other reader */
+    s.writer = NOBODY;
+    s.reader = (s.reader == NOBODY || s.reader == core) ? core : (int) MANY;
+}
+
+Migratory_detector::Slot &Migratory_detector::lookup (paddr_t addr)
+{
+    Slot &s = slots[line_hash (addr, MIGRATORY_TABLE_BITS)];
+    if (!s.used || s.addr != addr) {
+        s.used = true;
+        s.addr = addr;
+        s.writer = NOBODY;
+        s.reader = NOBODY;
+        s.migratory = false;
+    }
+    return s;
+}
@@ -0,0 +1,93 @@
+#ifndef MIGRATORY_H_
+#define MIGRATORY_H_
+
+#include "../sim/types.h"
+#include "../sim/module.h"
+#include "messages.h"
+#include "line_hash.h"
+
+/** log2 of the number of lines the detector remembers */
+#define MIGRATORY_TABLE_BITS 12
+
+/** Migratory sharing detector for the snooping bus.
+ *
+ * A migratory line is read and then written by one core at a time (a lock or
+ * a counter updated under one).  Plain MOESI pays two bus transactions per
+ * handoff: the reader's GETS leaves the old writer in O, then the reader's
+ * GETM (or UPGRADE, see set_upgrade) invalidates it.  Once a line is classified as migratory the M
+ * holder answers a GETS by handing the line over: it supplies the data as
+ * DATA_EXCL and drops to I, and the requester fills the line in M (the MC
+ * state) when that DATA_EXCL arrives, so the write that follows hits.
+ *
+ * Classification follows the usual read-then-write rule: a line becomes
+ * migratory when a core writes it after being the only core to read it since
+ * the last write by a different core.  It is declassified when a write
+ * follows reads by more than one core, or when a cache that was handed the
+ * line gives it up again without writing it (the MC state).
+ *
+ * The history is kept in a direct-mapped table of 1 << MIGRATORY_TABLE_BITS
+ * lines.  A line that maps to a slot held by another line replaces it, and
+ * the old line starts over unclassified, so the table never grows and
+ * forgetting a line only costs a handoff or two.
+ *
+ * The bus delivers a request to the caches in node order, sender included,
+ * so the sender's observe and the supplier's hand_over or declassify may come
+ * in either order, and the slot ends up the same either way.  Off by
+ * default; set enabled before the first request.  MOSI, MOESI and MOESIF
+ * consult it, the other protocols have no O state to hand over from.
+ */
+class Migratory_detector
+{
+public:
+    Migratory_detector ();
+
+    bool enabled;
+
+    /** True if GETS for addr should take the line over in M */
+    inline bool is_migratory (paddr_t addr)
+    {
+        if (!enabled)
+            return false;
+        Slot &s = slots[line_hash (addr, MIGRATORY_TABLE_BITS)];
+        return s.used && s.addr == addr && s.migratory;
+    }
+
+    /** The M holder answered src's GETS for addr by giving up its copy.  src
+     * fills the line in M, so this counts the write it is about to do
+     */
+    void hand_over (paddr_t addr, ModuleID src);
+
+    /** Called by the sender of a GETS, GETM or UPGRADE when it sees its own
+     * request on the bus
+     */
+    void observe (message_t msg, paddr_t addr, ModuleID src);
+
+    /** A handed over line left core before it was written */
+    void declassify (paddr_t addr, int core);
+
+private:
+    /** No core, and more than one core */
+    enum { NOBODY = -1, MANY = -2 };
+
+    struct Slot
+    {
+        paddr_t addr;
+        /** Last core to write the line, NOBODY if not known */
+        int writer;
+        /** Core that read the line since the last write, NOBODY or MANY */
+        int reader;
+        bool migratory;
+        bool used;
+    };
+
+    /** Direct mapped, tagged with addr */
+    Slot slots[1 << MIGRATORY_TABLE_BITS];
+
+    /** addr's slot, taken over from whatever line held it before */
+    Slot &lookup (paddr_t addr);
+};
+
+/** There is one detector for the bus */
+extern Migratory_detector Migratory_lines;
+
+#endif /* MIGRATORY_H_ */
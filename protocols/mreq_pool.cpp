@@ -0,0 +1,56 @@
+#include <new>
+#include "mreq_pool.h"
+
+Mreq_pool Mreq_allocator;
+
+Mreq_pool::Mreq_pool ()
+{
+    free_list = NULL;
+    consumers_release = false;
+    allocations = 0;
+    allocations_avoided = 0;
+}
+
+Mreq_pool::~Mreq_pool ()
+{
+    while (free_list) {
+        Free_block *block = free_list;
+        free_list = block->next;
+        ::operator delete (block);
+    }
+}
+
+void *Mreq_pool::get_block ()
+{
+    if (free_list) {
+        Free_block *block = free_list;
+        free_list = block->next;
+        allocations_avoided++;
+        return block;
+    }
+
+    allocations++;
+    return ::operator new (sizeof (Mreq));
+}
+
+Mreq *Mreq_pool::alloc (message_t msg, paddr_t addr)
+{
+    return new (get_block ()) Mreq (msg, addr);
+}
+
+Mreq *Mreq_pool::alloc (message_t msg, paddr_t addr, ModuleID src_mid, ModuleID dest_mid)
+{
+    return new (get_block ()) Mreq (msg, addr, src_mid, dest_mid);
+}
+
+void Mreq_pool::release (Mreq *request)
+{
+    if (request == NULL)
+        return;
+
+    request->~Mreq ();
+
+    Free_block *block = reinterpret_cast<Free_block *>(request);
+    block->next = free_list;
+    free_list = block;
+}
@@ -0,0 +1,59 @@
+#ifndef MREQ_POOL_H_
+#define MREQ_POOL_H_
+
+#include "../sim/types.h"
+#include "../sim/module.h"
+#include "../sim/mreq.h"
+
+/** Free list for the Mreq messages created by the Protocol::send_* helpers.
+ *
+ * Messages only live for a few cycles, so instead of new/delete per bus or
+ * processor message the consumer hands them back with release() and the next
+ * alloc() reuses the block.  Every block is obtained with operator new, so a
+ * message that is still freed with a plain delete is handled correctly; it just
+ * doesn't get recycled.
+ *
+ * By default the bus owns every message it delivers and frees it, as it
+ * always has.  A bus that stops deleting point-to-point messages sets
+ * consumers_release, and then a message addressed to one module is released
+ * by the module that consumes it: Protocol_template once the snoop is
+ * handled, Directory_controller once process_request returns.  Never set it
+ * while the bus still frees those messages itself, the block would be freed
+ * twice.
+ */
+class Mreq_pool
+{
+public:
+    Mreq_pool ();
+    ~Mreq_pool ();
+
+    /** Same arguments as the Mreq constructors */
+    Mreq *alloc (message_t msg, paddr_t addr);
+    Mreq *alloc (message_t msg, paddr_t addr, ModuleID src_mid, ModuleID dest_mid);
+
+    /** Call this instead of delete once a message has been consumed */
+    void release (Mreq *request);
+
+    /** Off by default; the consumer of a point-to-point message releases it */
+    bool consumers_release;
+
+    /** Number of messages that had to be heap allocated */
+    unsigned long long allocations;
+    /** Number of messages served from the free list instead of the heap */
+    unsigned long long allocations_avoided;
+
+private:
+    struct Free_block
+    {
+        Free_block *next;
+    };
+
+    Free_block *free_list;
+
+    void *get_block ();
+};
+
+/** There is one pool for the whole simulation */
+extern Mreq_pool Mreq_allocator;
+
+#endif /* MREQ_POOL_H_ */
@@ -2,9 +2,18 @@
 #include "../sim/sharers.h"
 #include "../sim/hash_table.h"
 #include "../sim/sim.h"
+#include "mreq_pool.h"
+#include "trace_log.h"
+#include "stats.h"
+#include "bus_stats.h"
+#include "split_bus.h"
+#include "update_sharing.h"
 
 extern Simulator * Sim;
 
+bool Protocol::use_directory = false;
+ModuleID Protocol::directory_mid;
+
 Protocol::Protocol (Hash_table *my_table, Hash_entry *my_entry)
 {
     this->my_table = my_table;
@@ -20,9 +29,18 @@ void Protocol::send_GETM(paddr_t addr)
 	/* Create a new message to send on the bus */
 	Mreq * new_request;
 	/* The arguments to Mreq are -- msg, address, src_id (optional), dest_id (optional) */
-	new_request = new Mreq(GETM,addr);
+	if (use_directory)
+		new_request = Mreq_allocator.alloc(GETM, addr, my_table->moduleID, directory_mid);
+	else
+		new_request = Mreq_allocator.alloc(GETM,addr);
+	Bus_usage.queued(my_table->moduleID, new_request, Global_Clock);
+	/* On a split-transaction bus this opens the request phase */
+	if (!use_directory)
+		Split_transactions.request(addr, my_table->moduleID, Global_Clock);
 	/* This will but the message in the bus' arbitration queue to sent */
 	this->my_table->write_to_bus(new_request);
+
+	Stats.core(my_table->moduleID.nodeID).sent[GETM]++;
 }
 
 void Protocol::send_GETS(paddr_t addr)
@@ -30,24 +48,52 @@ void Protocol::send_GETS(paddr_t addr)
 	/* Create a new message to send on the bus */
 	Mreq * new_request;
 	/* The arguments to Mreq are -- msg, address, src_id (optional), dest_id (optional) */
-	new_request = new Mreq(GETS,addr);
+	if (use_directory)
+		new_request = Mreq_allocator.alloc(GETS, addr, my_table->moduleID, directory_mid);
+	else
+		new_request = Mreq_allocator.alloc(GETS,addr);
+	Bus_usage.queued(my_table->moduleID, new_request, Global_Clock);
+	/* On a split-transaction bus this opens the request phase */
+	if (!use_directory)
+		Split_transactions.request(addr, my_table->moduleID, Global_Clock);
 	/* This will but the message in the bus' arbitration queue to sent */
 	this->my_table->write_to_bus(new_request);
+
+	Stats.core(my_table->moduleID.nodeID).sent[GETS]++;
+}
+
+void Protocol::send_UPGRADE(paddr_t addr)
+{
+	Mreq * new_request;
+	if (use_directory)
+		new_request = Mreq_allocator.alloc(UPGRADE, addr, my_table->moduleID, directory_mid);
+	else
+		new_request = Mreq_allocator.alloc(UPGRADE, addr);
+	Bus_usage.queued(my_table->moduleID, new_request, Global_Clock);
+	this->my_table->write_to_bus(new_request);
+
+	Stats.core(my_table->moduleID.nodeID).sent[UPGRADE]++;
 }
 
-void Protocol::send_DATA_on_bus(paddr_t addr, ModuleID dest)
+void Protocol::send_DATA_on_bus(paddr_t addr, ModuleID dest, message_t msg)
 {
 	/* Create a new message to send on the bus */
 	Mreq * new_request;
 	/* The arguments to Mreq are -- msg, address, src_id (optional), dest_id (optional) */
 	// When DATA is sent on the bus it _MUST_ have a destination module
-	new_request = new Mreq(DATA, addr, my_table->moduleID, dest);
+	new_request = Mreq_allocator.alloc(msg, addr, my_table->moduleID, dest);
 	/* Debug Message -- DO NOT REMOVE or you won't match the validation runs */
-	fprintf(stderr,"**** DATA_SEND Cache: %d -- Clock: %lld\n",my_table->moduleID.nodeID,Global_Clock);
+	if (TRACE_ON(LOG_VALIDATION))
+		fprintf(stderr,"**** DATA_SEND Cache: %d -- Clock: %lld\n",my_table->moduleID.nodeID,Global_Clock);
+	Bus_usage.queued(my_table->moduleID, new_request, Global_Clock);
+	/* The response phase of dest's transaction */
+	Split_transactions.response(addr, dest, Global_Clock);
 	/* This will but the message in the bus' arbitration queue to sent */
 	this->my_table->write_to_bus(new_request);
 
 	Sim->cache_to_cache_transfers++;
+	Stats.core(my_table->moduleID.nodeID).cache_to_cache_transfers++;
+	Stats.core(my_table->moduleID.nodeID).sent[msg]++;
 }
 
 void Protocol::send_DATA_to_proc(paddr_t addr)
@@ -56,13 +102,61 @@ void Protocol::send_DATA_to_proc(paddr_t addr)
 	Mreq * new_request;
 	/* The arguments to Mreq are -- msg, address, src_id (optional), dest_id (optional) */
 	// When data is sent from a cache to proc, there is no need to set the src and dest
-	new_request = new Mreq(DATA,addr);
+	new_request = Mreq_allocator.alloc(DATA,addr);
 	/* This writes the message into the processor's input buffer.  The processor
 	 * only expects to ever receive DATA messages
 	 */
 	this->my_table->write_to_proc(new_request);
 }
 
+void Protocol::send_DATA_to_dir(paddr_t addr)
+{
+	/* Write the (possibly dirty) line back to the directory */
+	Mreq * new_request;
+	new_request = Mreq_allocator.alloc(DATA, addr, my_table->moduleID, directory_mid);
+	Bus_usage.queued(my_table->moduleID, new_request, Global_Clock);
+	this->my_table->write_to_bus(new_request);
+
+	Stats.core(my_table->moduleID.nodeID).sent[DATA]++;
+}
+
+void Protocol::send_INV_ACK(paddr_t addr)
+{
+	/* Tell the directory an invalidation or forwarded request is done */
+	Mreq * new_request;
+	new_request = Mreq_allocator.alloc(INV_ACK, addr, my_table->moduleID, directory_mid);
+	Bus_usage.queued(my_table->moduleID, new_request, Global_Clock);
+	this->my_table->write_to_bus(new_request);
+
+	Stats.core(my_table->moduleID.nodeID).sent[INV_ACK]++;
+}
+
+void Protocol::send_PUTM(paddr_t addr)
+{
+	Mreq * new_request;
+	if (use_directory)
+		new_request = Mreq_allocator.alloc(PUTM, addr, my_table->moduleID, directory_mid);
+	else
+		new_request = Mreq_allocator.alloc(PUTM, addr);
+	Bus_usage.queued(my_table->moduleID, new_request, Global_Clock);
+	this->my_table->write_to_bus(new_request);
+
+	Stats.core(my_table->moduleID.nodeID).sent[PUTM]++;
+}
+
+void Protocol::send_UPDATE(paddr_t addr)
+{
+	/* Carries the written word, not the whole line, sharers merge it */
+	Mreq * new_request;
+	new_request = Mreq_allocator.alloc(UPDATE, addr);
+	Bus_usage.queued(my_table->moduleID, new_request, Global_Clock);
+	/* The sharers that keep their copies record it, see update_sharing.h */
+	Update_sharers.sent(addr, my_table->moduleID.nodeID);
+	this->my_table->write_to_bus(new_request);
+
+	Stats.core(my_table->moduleID.nodeID).sent[UPDATE]++;
+}
+
 void Protocol::set_shared_line ()
 {
 	// Set the bus' shared line
@@ -44,11 +44,27 @@ public:
      */
     void send_GETM(paddr_t addr);
     void send_GETS(paddr_t addr);
-    void send_DATA_on_bus(paddr_t addr, ModuleID dest);
+    /** GETM from a cache that already has the data, only the address is sent */
+    void send_UPGRADE(paddr_t addr);
+    /** DATA_EXCL hands a migratory line over with the data, see migratory.h */
+    void send_DATA_on_bus(paddr_t addr, ModuleID dest, message_t msg = DATA);
     void send_DATA_to_proc(paddr_t addr);
+    /** These are only used by the directory protocols */
+    void send_DATA_to_dir(paddr_t addr);
+    void send_INV_ACK(paddr_t addr);
+    /** Writeback of an evicted line, to memory or the directory */
+    void send_PUTM(paddr_t addr);
+    /** Broadcast of a write to a shared line, used by the write-update protocols */
+    void send_UPDATE(paddr_t addr);
     /** These helper functions are for setting and getting the bus' shared line */
     void set_shared_line();
     bool get_shared_line();
+
+    /** When set, GETS/GETM/UPGRADE go point-to-point to directory_mid instead
+     * of being broadcast on the bus.  See directory.h
+     */
+    static bool use_directory;
+    static ModuleID directory_mid;
 };
 
 #endif /* PROTOCOL_H_ */
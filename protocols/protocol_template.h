@@ -0,0 +1,363 @@
+#ifndef PROTOCOL_TEMPLATE_H_
+#define PROTOCOL_TEMPLATE_H_
+
+#include "protocol.h"
+#include "transition_table.h"
+#include "stats.h"
+#include "snoop_filter.h"
+#include "cache_array.h"
+#include "migratory.h"
+#include "update_sharing.h"
+#include "mreq_pool.h"
+#include "trace_log.h"
+#include "../sim/sim.h"
+#include "../sim/hash_table.h"
+
+extern Simulator *Sim;
+
+/** Compile-time specialized protocol base (CRTP).
+ *
+ * Derived must provide
+ *     typedef <enum> state_t;
+ *     state_t state;
+ *     static const state_t initial_state;
+ *     static const char *const name;
+ *     static const char *const state_names[<num states>];
+ *     static const bool owner_states[<num states>];
+ *     static const Transition transitions[<num states>][MREQ_MESSAGE_NUM];
+ *     static void dump_state (unsigned char state);
+ *
+ * The simulator only holds Protocol * and calls the virtual
+ * process_cache_request/process_snoop_request once per message; inside that one
+ * call the table lookup and actions (cache_request/snoop_request, transition)
+ * are resolved at compile time and inlined per protocol.
+ */
+template <class Derived>
+class Protocol_template : public Protocol
+{
+public:
+    Protocol_template (Hash_table *my_table, Hash_entry *my_entry)
+        : Protocol (my_table, my_entry)
+    {
+        /* The Core_stats arrays are indexed by state unchecked, a protocol with
+         * more states than STATS_MAX_STATES fails to compile here (C++98 has no
+         * static_assert)
+         */
+        typedef char states_fit_stats[(sizeof (Derived::state_names) / sizeof (Derived::state_names[0]) <= STATS_MAX_STATES
+                                       && sizeof (Derived::transitions) / sizeof (Derived::transitions[0]) <= STATS_MAX_STATES) ? 1 : -1]
+            __attribute__ ((unused));
+
+        Stats.set_protocol (Derived::name, Derived::state_names,
+                            sizeof (Derived::state_names) / sizeof (Derived::state_names[0]));
+        /* The one instance serving a Cache_array (NULL my_entry) reports lines as they are filled */
+        if (my_entry)
+            core_stats ().line_added (Derived::initial_state, Global_Clock);
+    }
+
+    /** Stateless entry point: runs request against the line whose coherence
+     * state is held in state, e.g. a Cache_array line.  Nothing about the line
+     * is kept in the object, so one instance per Hash_table (with a NULL
+     * my_entry) can serve every line of that cache.
+     */
+    inline void handle_request (Mreq *request, unsigned char &state)
+    {
+        check_state (state);
+        /* A state waiting for the snoops of its own UPDATE, see TRANS_SETTLE */
+        if (Derived::transitions[state][NOP].next)
+            state = settle (Derived::transitions[state][NOP], request->addr, state);
+        state = transition (Derived::transitions[state][request->msg], request, state);
+    }
+
+    inline void cache_request (Mreq *request)
+    {
+        Derived *self = static_cast<Derived *>(this);
+        unsigned char state = self->state;
+        handle_request (request, state);
+        self->state = (typename Derived::state_t) state;
+    }
+
+    inline void snoop_request (Mreq *request)
+    {
+        Derived *self = static_cast<Derived *>(this);
+        unsigned char state = self->state;
+        handle_request (request, state);
+        self->state = (typename Derived::state_t) state;
+        consumed (request);
+    }
+
+    /** Processor request against a capacity-limited cache.  On a miss the
+     * victim's line is evicted through the protocol first.  Returns false if
+     * the line can't be allocated yet (every way of the set has a request in
+     * flight, or the line is still being written back), the caller retries.
+     */
+    inline bool cache_request (Cache_array &array, Mreq *request)
+    {
+        Cache_array::Line *line = array.lookup (request->addr);
+
+        if (!line) {
+            if (array.lookup_any (request->addr))
+                return false;
+            line = array.victim (request->addr);
+            if (!line)
+                return false;
+            if (line->valid && line->state != Derived::initial_state)
+                evict (array, line);
+            else if (!line->valid)
+                core_stats ().line_added (Derived::initial_state, Global_Clock);
+            line = array.fill (line, request->addr);
+        }
+        array.touch (line);
+        handle_request (request, line->state);
+        if (line->invalidate_pending)
+            deferred_invalidate (array, line);
+        return true;
+    }
+
+    /** Snoop against a capacity-limited cache.  A line that isn't there is in I */
+    inline void snoop_request (Cache_array &array, Mreq *request)
+    {
+        Cache_array::Line *line = array.lookup_any (request->addr);
+
+        if (!line) {
+            unsigned char state = Derived::initial_state;
+            handle_request (request, state);
+            consumed (request);
+            return;
+        }
+        handle_request (request, line->state);
+        if (!array.in_array (line) && line->state == Derived::initial_state) {
+            core_stats ().line_removed (Derived::initial_state, Global_Clock);
+            array.release (line);
+        } else if (line->invalidate_pending) {
+            deferred_invalidate (array, line);
+        }
+        consumed (request);
+    }
+
+    /** Inclusive outer level dropped addr (see cache_hierarchy.h): evict it like a
+     * replacement would.  A line with a request in flight is marked and evicted
+     * once the request is done.  Returns false if the line wasn't here
+     */
+    inline bool back_invalidate (Cache_array &array, paddr_t addr)
+    {
+        Cache_array::Line *line = array.lookup (addr);
+
+        if (!line || line->state == Derived::initial_state)
+            return false;
+        if (can_evict (line->state)) {
+            evict (array, line);
+        } else if (!line->invalidate_pending) {
+            line->invalidate_pending = true;
+            core_stats ().back_invalidations_deferred++;
+        }
+        return true;
+    }
+
+    /** States a line may be replaced in: the ones whose row handles EVICT, and
+     * the ones that settle into such a state first
+     */
+    static bool can_evict (unsigned char state)
+    {
+        return Derived::transitions[state][EVICT].next != 0 || Derived::transitions[state][NOP].next != 0;
+    }
+
+    void dump (void) { Derived::dump_state (static_cast<Derived *>(this)->state); }
+
+    void process_cache_request (Mreq *request) { cache_request (request); }
+    void process_snoop_request (Mreq *request) { snoop_request (request); }
+
+protected:
+    /** Sets every entry in patches to its on or off version, for tables that
+     * aren't const
+     */
+    static void patch_transitions (const Transition_patch *patches, bool on)
+    {
+        for (; patches->state; patches++)
+            Derived::transitions[patches->state][patches->msg] = on ? patches->on : patches->off;
+    }
+
+private:
+    /** Looked up per use rather than kept in every per-line Protocol */
+    inline Core_stats &core_stats ()
+    {
+        return Stats.core (my_table->moduleID.nodeID);
+    }
+
+    inline void evict (Cache_array &array, Cache_array::Line *line)
+    {
+        Mreq request (EVICT, line->addr);
+
+        core_stats ().evictions++;
+        handle_request (&request, line->state);
+        /* Still writing back, the way gets a new line */
+        if (line->state != Derived::initial_state) {
+            array.hold (line);
+            core_stats ().line_added (Derived::initial_state, Global_Clock);
+        }
+    }
+
+    /** Carries out a back-invalidation that found line's request in flight,
+     * once the line is back in a state it can be evicted from
+     */
+    inline void deferred_invalidate (Cache_array &array, Cache_array::Line *line)
+    {
+        if (line->state == Derived::initial_state) {
+            line->invalidate_pending = false;
+        } else if (can_evict (line->state)) {
+            line->invalidate_pending = false;
+            evict (array, line);
+        }
+    }
+
+    /** A message sent to this cache alone ends here, see mreq_pool.h */
+    inline void consumed (Mreq *request)
+    {
+        if (Mreq_allocator.consumers_release && request->dest_mid == my_table->moduleID)
+            Mreq_allocator.release (request);
+    }
+
+    static inline void check_state (unsigned char state)
+    {
+        if (state >= sizeof (Derived::transitions) / sizeof (Derived::transitions[0]))
+            Trace_log::fatal ("Invalid Cache State for Protocol\n");
+    }
+
+    /** Moves a line out of the state its own UPDATE left it in, once every
+     * cache has snooped the UPDATE
+     */
+    inline unsigned char settle (const Transition &t, paddr_t addr, unsigned char state)
+    {
+        unsigned char next = Update_sharers.shared (addr, my_table->moduleID.nodeID) ? t.next : t.alt;
+
+        core_stats ().transition (state, NOP, next, Global_Clock);
+        return next;
+    }
+
+    /** Applies the actions of a transition table entry to request and returns
+     * the state the line should move to.  See transition_table.h
+     */
+    inline unsigned char transition (const Transition &t, Mreq *request, unsigned char state)
+    {
+        unsigned short actions = t.actions;
+        /* Decided before the actions, a hand over changes the DATA sent */
+        bool hand_over = t.cond == NEXT_IF_MIGRATORY && Migratory_lines.is_migratory (request->addr);
+
+#ifndef NO_STATS
+        core_stats ().requests[request->msg]++;
+        core_stats ().state_requests[state]++;
+#endif
+
+        /* Zero entries (and TRANS_ERROR) have the unused state 0 as next state */
+        if (t.next == 0) {
+            request->print_msg (my_table->moduleID, "ERROR");
+            Trace_log::fatal ("Client: state shouldn't see this message\n");
+        }
+
+        /* A sender's own broadcast only picks its next state */
+        if (t.cond == NEXT_IF_OWN_UPDATE && request->src_mid == my_table->moduleID)
+            actions = ACT_NONE;
+        else if (t.cond == NEXT_IF_OWN && request->src_mid != my_table->moduleID)
+            actions = ACT_NONE;
+
+        if (actions & ACT_SET_SHARED) {
+            set_shared_line();
+            if (request->msg == UPDATE && request->src_mid != my_table->moduleID)
+                Update_sharers.kept (request->addr, request->src_mid.nodeID);
+        }
+        if (actions & ACT_SEND_GETS)
+            send_GETS(request->addr);
+        if (actions & ACT_SEND_GETM)
+            send_GETM(request->addr);
+        if (actions & ACT_SEND_UPGRADE)
+            send_UPGRADE(request->addr);
+        if (actions & ACT_SEND_DATA_BUS)
+            send_DATA_on_bus(request->addr, request->src_mid, hand_over ? DATA_EXCL : DATA);
+        if (actions & ACT_SEND_DATA_DIR)
+            send_DATA_to_dir(request->addr);
+        if (actions & ACT_SEND_INV_ACK)
+            send_INV_ACK(request->addr);
+        if (actions & ACT_SEND_PUTM)
+            send_PUTM(request->addr);
+        if (actions & ACT_SEND_UPDATE)
+            send_UPDATE(request->addr);
+        if (actions & ACT_SEND_DATA_PROC)
+            send_DATA_to_proc(request->addr);
+        if (actions & ACT_CACHE_MISS) {
+            Sim->cache_misses++;
+            core_stats ().cache_misses++;
+#ifndef NO_STATS
+            core_stats ().miss_started (request->msg, Global_Clock);
+#endif
+        }
+        if (actions & ACT_SILENT_UPGRADE) {
+            Sim->silent_upgrades++;
+            core_stats ().silent_upgrades++;
+        }
+        if (actions & ACT_APPLY_UPDATE)
+            core_stats ().updates_applied++;
+        if (actions & ACT_DATA_SAVED) {
+            core_stats ().data_transfers_saved++;
+#ifndef NO_STATS
+            core_stats ().miss_supplied (SUPPLIER_NONE);
+#endif
+        }
+        if ((actions & ACT_DECLASSIFY) && Migratory_lines.enabled)
+            Migratory_lines.declassify (request->addr, my_table->moduleID.nodeID);
+#ifndef NO_STATS
+        /* The supplier's snoop comes before the requester's DATA */
+        if (actions & ACT_SEND_DATA_BUS)
+            Stats.core (request->src_mid.nodeID).miss_supplied (supplier_of (state));
+        /* After CACHE_MISS and DATA_SAVED, a miss may end in the transition that started it */
+        if (actions & ACT_SEND_DATA_PROC)
+            core_stats ().miss_done (Global_Clock);
+#endif
+
+        unsigned char next;
+        switch (t.cond) {
+        case NEXT_IF_SHARED:
+            next = get_shared_line() ? t.next : t.alt;
+            break;
+        case NEXT_IF_OTHER:
+            next = (request->src_mid != my_table->moduleID) ? t.next : t.alt;
+            break;
+        case NEXT_IF_OWN:
+        case NEXT_IF_OWN_UPDATE:
+            next = (request->src_mid == my_table->moduleID) ? t.next : t.alt;
+            break;
+        case NEXT_IF_MIGRATORY:
+            if (hand_over) {
+                Migratory_lines.hand_over (request->addr, request->src_mid);
+                core_stats ().migratory_handoffs++;
+                next = t.next;
+            } else
+                next = t.alt;
+            break;
+        default:
+            next = t.next;
+        }
+
+        if (Snoop_presence.enabled && next != state) {
+            if (state == Derived::initial_state)
+                Snoop_presence.line_valid (request->addr, my_table->moduleID.nodeID);
+            else if (next == Derived::initial_state)
+                Snoop_presence.line_invalid (request->addr, my_table->moduleID.nodeID);
+        }
+
+        /* Each request is counted once, by its sender.  The suppliers may snoop
+         * it before or after, see migratory.h
+         */
+        if (Migratory_lines.enabled && request->src_mid == my_table->moduleID)
+            Migratory_lines.observe (request->msg, request->addr, request->src_mid);
+
+        core_stats ().transition (state, request->msg, next, Global_Clock);
+        return next;
+    }
+
+    /** Dirty states supply as owners, each protocol lists them in owner_states */
+    static inline supplier_t supplier_of (unsigned char state)
+    {
+        return Derived::owner_states[state] ? SUPPLIER_OWNER : SUPPLIER_FORWARDER;
+    }
+};
+
+#endif /* PROTOCOL_TEMPLATE_H_ */
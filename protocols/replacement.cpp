@@ -0,0 +1,172 @@
+#include <string.h>
+#include "replacement.h"
+#include "../sim/types.h"
+
+#define RRPV_MAX 3
+
+Replacement_policy *Replacement_policy::create (replacement_t kind, unsigned int sets, unsigned int assoc)
+{
+    switch (kind) {
+    case REPL_LRU:    return new LRU_policy (sets, assoc);
+    case REPL_PLRU:   return new PLRU_policy (sets, assoc);
+    case REPL_RRIP:   return new RRIP_policy (sets, assoc);
+    case REPL_RANDOM: return new Random_policy (sets, assoc);
+    default:
+        fatal_error ("Invalid replacement policy\n");
+    }
+    return NULL;
+}
+
+bool Replacement_policy::parse (const char *name, replacement_t *kind)
+{
+    if (!strcmp (name, "lru"))
+        *kind = REPL_LRU;
+    else if (!strcmp (name, "plru"))
+        *kind = REPL_PLRU;
+    else if (!strcmp (name, "rrip"))
+        *kind = REPL_RRIP;
+    else if (!strcmp (name, "random"))
+        *kind = REPL_RANDOM;
+    else
+        return false;
+    return true;
+}
+
+/*************************
+ * LRU
+ *************************/
+
+LRU_policy::LRU_policy (unsigned int sets, unsigned int assoc)
+    : assoc (assoc), clock (0), stamps (sets * assoc, 0)
+{
+}
+
+void LRU_policy::touch (unsigned int set, unsigned int way)
+{
+    stamps[set * assoc + way] = ++clock;
+}
+
+void LRU_policy::insert (unsigned int set, unsigned int way)
+{
+    stamps[set * assoc + way] = ++clock;
+}
+
+int LRU_policy::victim (unsigned int set, const std::vector<bool> &allowed)
+{
+    int best = -1;
+    for (unsigned int w = 0; w < assoc; w++)
+        if (allowed[w] && (best < 0 || stamps[set * assoc + w] < stamps[set * assoc + best]))
+            best = w;
+    return best;
+}
+
+/*************************
+ * Tree PLRU
+ *************************/
+
+PLRU_policy::PLRU_policy (unsigned int sets, unsigned int assoc)
+    : assoc (assoc), bits (sets * assoc, false)
+{
+    if (assoc & (assoc - 1))
+        fatal_error ("PLRU needs a power of two associativity\n");
+}
+
+/** Point every node on the path to way away from it */
+void PLRU_policy::touch (unsigned int set, unsigned int way)
+{
+    unsigned int node = 1;
+    for (unsigned int half = assoc / 2; half > 0; half /= 2) {
+        bool right = (way & half) != 0;
+        bits[set * assoc + node] = !right;
+        node = 2 * node + right;
+    }
+}
+
+int PLRU_policy::victim (unsigned int set, const std::vector<bool> &allowed)
+{
+    unsigned int node = 1;
+    unsigned int way = 0;
+
+    /* Follow the tree, but never into a half with no allowed way */
+    for (unsigned int half = assoc / 2; half > 0; half /= 2) {
+        bool right = bits[set * assoc + node];
+        unsigned int first = way + (right ? half : 0);
+        bool any = false;
+        for (unsigned int w = first; w < first + half; w++)
+            any = any || allowed[w];
+        if (!any)
+            right = !right;
+        if (right)
+            way |= half;
+        node = 2 * node + right;
+    }
+    return allowed[way] ? (int) way : -1;
+}
+
+/*************************
+ * Static RRIP
+ *************************/
+
+RRIP_policy::RRIP_policy (unsigned int sets, unsigned int assoc)
+    : assoc (assoc), rrpv (sets * assoc, RRPV_MAX)
+{
+}
+
+void RRIP_policy::touch (unsigned int set, unsigned int way)
+{
+    rrpv[set * assoc + way] = 0;
+}
+
+/** New lines are predicted to be re-referenced in the long, not distant, future */
+void RRIP_policy::insert (unsigned int set, unsigned int way)
+{
+    rrpv[set * assoc + way] = RRPV_MAX - 1;
+}
+
+int RRIP_policy::victim (unsigned int set, const std::vector<bool> &allowed)
+{
+    unsigned char *v = &rrpv[set * assoc];
+    unsigned char oldest = 0;
+    int best = -1;
+
+    /* Same choice as ageing the whole set until an allowed line hits RRPV_MAX,
+     * without looping
+     */
+    for (unsigned int w = 0; w < assoc; w++) {
+        if (allowed[w] && (best < 0 || v[w] > oldest)) {
+            best = w;
+            oldest = v[w];
+        }
+    }
+    if (best >= 0 && oldest < RRPV_MAX) {
+        unsigned char age = RRPV_MAX - oldest;
+        for (unsigned int w = 0; w < assoc; w++)
+            v[w] = v[w] + age > RRPV_MAX ? RRPV_MAX : v[w] + age;
+    }
+    return best;
+}
+
+/*************************
+ * Random
+ *************************/
+
+Random_policy::Random_policy (unsigned int sets, unsigned int assoc)
+    : assoc (assoc), seed (1)
+{
+}
+
+int Random_policy::victim (unsigned int set, const std::vector<bool> &allowed)
+{
+    unsigned int count = 0;
+    for (unsigned int w = 0; w < assoc; w++)
+        count += allowed[w];
+    if (count == 0)
+        return -1;
+
+    seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+    unsigned int pick = (unsigned int) (seed >> 33) % count;
+    for (unsigned int w = 0; w < assoc; w++)
+        if (allowed[w] && pick-- == 0)
+            return w;
+    return -1;
+}
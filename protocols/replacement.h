@@ -0,0 +1,92 @@
+#ifndef REPLACEMENT_H_
+#define REPLACEMENT_H_
+
+#include <vector>
+
+typedef enum {
+    REPL_LRU = 0,
+    REPL_PLRU,		// Tree pseudo-LRU, needs a power of two associativity
+    REPL_RRIP,		// Static RRIP with 2-bit re-reference predictions
+    REPL_RANDOM
+} replacement_t;
+
+/** Replacement state of a whole Cache_array, indexed by set and way.
+ *
+ * victim() only considers the ways whose allowed flag is set, so the cache can
+ * keep lines with a request in flight out of the choice.  It returns -1 if no
+ * way is allowed.
+ */
+class Replacement_policy
+{
+public:
+    virtual ~Replacement_policy () {}
+
+    /** The line in set/way was hit */
+    virtual void touch (unsigned int set, unsigned int way) =0;
+    /** A new line was filled into set/way */
+    virtual void insert (unsigned int set, unsigned int way) =0;
+    virtual int victim (unsigned int set, const std::vector<bool> &allowed) =0;
+
+    static Replacement_policy *create (replacement_t kind, unsigned int sets, unsigned int assoc);
+    /** "lru", "plru", "rrip" or "random", for command line options */
+    static bool parse (const char *name, replacement_t *kind);
+};
+
+class LRU_policy : public Replacement_policy
+{
+public:
+    LRU_policy (unsigned int sets, unsigned int assoc);
+    void touch (unsigned int set, unsigned int way);
+    void insert (unsigned int set, unsigned int way);
+    int victim (unsigned int set, const std::vector<bool> &allowed);
+
+private:
+    unsigned int assoc;
+    unsigned long long clock;
+    /** Last use of every line */
+    std::vector<unsigned long long> stamps;
+};
+
+class PLRU_policy : public Replacement_policy
+{
+public:
+    PLRU_policy (unsigned int sets, unsigned int assoc);
+    void touch (unsigned int set, unsigned int way);
+    void insert (unsigned int set, unsigned int way) { touch (set, way); }
+    int victim (unsigned int set, const std::vector<bool> &allowed);
+
+private:
+    unsigned int assoc;
+    /** assoc - 1 tree bits per set, a set bit points at the right half */
+    std::vector<bool> bits;
+};
+
+class RRIP_policy : public Replacement_policy
+{
+public:
+    RRIP_policy (unsigned int sets, unsigned int assoc);
+    void touch (unsigned int set, unsigned int way);
+    void insert (unsigned int set, unsigned int way);
+    int victim (unsigned int set, const std::vector<bool> &allowed);
+
+private:
+    unsigned int assoc;
+    /** Re-reference prediction value of every line, 3 means distant */
+    std::vector<unsigned char> rrpv;
+};
+
+class Random_policy : public Replacement_policy
+{
+public:
+    Random_policy (unsigned int sets, unsigned int assoc);
+    void touch (unsigned int set, unsigned int way) {}
+    void insert (unsigned int set, unsigned int way) {}
+    int victim (unsigned int set, const std::vector<bool> &allowed);
+
+private:
+    unsigned int assoc;
+    /** Own generator so runs are repeatable and don't disturb rand() users */
+    unsigned long long seed;
+};
+
+#endif /* REPLACEMENT_H_ */
@@ -0,0 +1,115 @@
+#include <math.h>
+#include <stdio.h>
+#include "sampling.h"
+#include "../sim/sim.h"
+
+extern Simulator *Sim;
+
+Sampler Sampling;
+
+Sampler::Sampler ()
+    : enabled (false), mode (SAMPLE_MEASURE), saved_level (LOG_OFF),
+      start_refs (0), start_cycles (0), start_misses (0), measured_refs (0)
+{
+    config.period = 0;
+    config.warmup = 0;
+    config.detailed = 0;
+    config.z = 1.96;
+}
+
+bool Sampler::configure (const Sampling_config &config)
+{
+    if (config.detailed == 0 || config.warmup + config.detailed > config.period)
+        return false;
+
+    this->config = config;
+    enabled = true;
+    /* Anything before the first reference counts as detailed, like an unsampled run */
+    mode = SAMPLE_WARMUP;
+    saved_level = Trace_log::level;
+    return true;
+}
+
+sample_mode_t Sampler::reference (unsigned long long refs, unsigned long long now)
+{
+    if (!enabled)
+        return SAMPLE_MEASURE;
+
+    unsigned long long pos = refs % config.period;
+    sample_mode_t next;
+    if (pos < config.period - config.warmup - config.detailed)
+        next = SAMPLE_FUNCTIONAL;
+    else if (pos < config.period - config.detailed)
+        next = SAMPLE_WARMUP;
+    else
+        next = SAMPLE_MEASURE;
+
+    if (next != mode)
+        switch_mode (next, refs, now);
+    return mode;
+}
+
+void Sampler::finish (unsigned long long refs, unsigned long long now)
+{
+    if (enabled && mode != SAMPLE_WARMUP)
+        switch_mode (SAMPLE_WARMUP, refs, now);
+}
+
+void Sampler::switch_mode (sample_mode_t next, unsigned long long refs, unsigned long long now)
+{
+    if (mode == SAMPLE_MEASURE && refs > start_refs) {
+        double n = refs - start_refs;
+        cycles_per_ref.push_back ((now - start_cycles) / n);
+        miss_rate.push_back ((Sim->cache_misses - start_misses) / n);
+        measured_refs += refs - start_refs;
+    }
+    if (next == SAMPLE_MEASURE) {
+        start_refs = refs;
+        start_cycles = now;
+        start_misses = Sim->cache_misses;
+    }
+
+    /* The trace stays off for the whole fast-forward */
+    if (next == SAMPLE_FUNCTIONAL) {
+        saved_level = Trace_log::level;
+        Trace_log::level = LOG_OFF;
+    } else if (mode == SAMPLE_FUNCTIONAL) {
+        Trace_log::level = saved_level;
+    }
+    mode = next;
+}
+
+/** Mean and confidence half-width (z standard errors) of samples */
+static void estimate (const std::vector<double> &samples, double z, double *mean, double *half_width)
+{
+    double sum = 0, sq = 0;
+    unsigned int n = samples.size ();
+
+    for (unsigned int i = 0; i < n; i++)
+        sum += samples[i];
+    *mean = n ? sum / n : 0;
+    for (unsigned int i = 0; i < n; i++)
+        sq += (samples[i] - *mean) * (samples[i] - *mean);
+    *half_width = n > 1 ? z * sqrt (sq / (n - 1) / n) : 0;
+}
+
+void Sampler::report (unsigned long long total_refs)
+{
+    double cpr, cpr_hw, mr, mr_hw;
+
+    if (!enabled)
+        return;
+
+    estimate (cycles_per_ref, config.z, &cpr, &cpr_hw);
+    estimate (miss_rate, config.z, &mr, &mr_hw);
+
+    fprintf (stderr, "Sampled Windows:   %6llu windows, %llu of %llu references measured\n",
+             windows (), measured_refs, total_refs);
+    if (windows () < 2) {
+        fprintf (stderr, "Too few windows for a confidence interval, shorten the period\n");
+        return;
+    }
+    fprintf (stderr, "Est. Run Time:     %.0f cycles +/- %.1f%% (z = %.2f)\n",
+             cpr * total_refs, cpr ? 100.0 * cpr_hw / cpr : 0.0, config.z);
+    fprintf (stderr, "Est. Miss Rate:    %.4f +/- %.4f\n", mr, mr_hw);
+}
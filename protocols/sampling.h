@@ -0,0 +1,82 @@
+#ifndef SAMPLING_H_
+#define SAMPLING_H_
+
+#include <vector>
+#include "../sim/types.h"
+#include "trace_log.h"
+
+/** How the simulator should run a reference */
+typedef enum {
+    SAMPLE_FUNCTIONAL = 0,	// Coherence state only: requests complete at once, no timing, no trace
+    SAMPLE_WARMUP,			// Detailed timing, not measured, refills the pipeline after fast-forward
+    SAMPLE_MEASURE			// Detailed timing, measured
+} sample_mode_t;
+
+typedef struct {
+    /** References (over all cores) per sampling unit */
+    unsigned long long period;
+    /** Detailed but unmeasured references before each window */
+    unsigned long long warmup;
+    /** Measured references per window, at the end of each period */
+    unsigned long long detailed;
+    /** Normal quantile of the reported confidence, 1.96 for 95% */
+    double z;
+} Sampling_config;
+
+/** SMARTS-style systematic sampling.
+ *
+ * Each period of references is mostly fast-forwarded functionally: the caches
+ * and protocols still see every reference, so coherence state and the cache
+ * contents stay warm, but the simulator completes each request at once without
+ * advancing Global_Clock and with the trace off.  The last warmup + detailed
+ * references of the period run with full timing and only the final detailed
+ * ones are measured.
+ *
+ * The simulator calls reference() before it issues each reference and runs it
+ * in the returned mode.  Before going from a detailed window back to
+ * functional it has to finish the requests still in flight.  At the end of
+ * the trace it calls finish(), and report() prints the Run Time and miss rate
+ * estimated from the windows, with confidence intervals from their variance.
+ */
+class Sampler
+{
+public:
+    Sampler ();
+
+    /** Turns sampling on.  Returns false if warmup + detailed doesn't fit in a period */
+    bool configure (const Sampling_config &config);
+
+    bool enabled;
+
+    /** refs is the number of references issued so far over all cores */
+    sample_mode_t reference (unsigned long long refs, unsigned long long now);
+    /** Closes a window still open when the trace ends */
+    void finish (unsigned long long refs, unsigned long long now);
+
+    /** Prints the estimates for a trace of total_refs references */
+    void report (unsigned long long total_refs);
+
+    unsigned long long windows (void) { return cycles_per_ref.size (); }
+
+private:
+    Sampling_config config;
+    sample_mode_t mode;
+    log_level_t saved_level;
+
+    /** Where the open window started */
+    unsigned long long start_refs;
+    unsigned long long start_cycles;
+    unsigned long long start_misses;
+    unsigned long long measured_refs;
+
+    /** One entry per finished window */
+    std::vector<double> cycles_per_ref;
+    std::vector<double> miss_rate;
+
+    void switch_mode (sample_mode_t next, unsigned long long refs, unsigned long long now);
+};
+
+/** There is one sampler for the simulation */
+extern Sampler Sampling;
+
+#endif /* SAMPLING_H_ */
@@ -0,0 +1,58 @@
+#include "snoop_filter.h"
+
+Snoop_filter Snoop_presence;
+
+#define SNOOP_FILTER_INITIAL_BITS 12
+
+Snoop_filter::Snoop_filter ()
+    : enabled (false), used (0), bits (SNOOP_FILTER_INITIAL_BITS)
+{
+    Slot empty = {0, 0, false};
+    slots.resize (1 << SNOOP_FILTER_INITIAL_BITS, empty);
+}
+
+void Snoop_filter::line_valid (paddr_t addr, int core)
+{
+    if (!enabled || core >= SNOOP_FILTER_MAX_CORES)
+        return;
+
+    unsigned int i = find (addr);
+    if (!slots[i].used) {
+        /* Keep the table at most half full */
+        if (2 * (used + 1) > slots.size ()) {
+            grow ();
+            i = find (addr);
+        }
+        slots[i].used = true;
+        slots[i].addr = addr;
+        slots[i].holders = 0;
+        used++;
+    }
+    slots[i].holders |= 1ULL << core;
+}
+
+void Snoop_filter::line_invalid (paddr_t addr, int core)
+{
+    if (!enabled || core >= SNOOP_FILTER_MAX_CORES)
+        return;
+
+    unsigned int i = find (addr);
+    if (slots[i].used)
+        slots[i].holders &= ~(1ULL << core);
+}
+
+void Snoop_filter::grow ()
+{
+    std::vector<Slot> old;
+    Slot empty = {0, 0, false};
+
+    old.swap (slots);
+    slots.resize (old.size () * 2, empty);
+    bits++;
+
+    for (unsigned int j = 0; j < old.size (); j++) {
+        if (!old[j].used)
+            continue;
+        slots[find (old[j].addr)] = old[j];
+    }
+}
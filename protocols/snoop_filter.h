@@ -0,0 +1,82 @@
+#ifndef SNOOP_FILTER_H_
+#define SNOOP_FILTER_H_
+
+#include <vector>
+#include "../sim/types.h"
+#include "stats.h"
+#include "line_hash.h"
+
+/** Caches beyond this many are always snooped */
+#define SNOOP_FILTER_MAX_CORES 64
+
+/** Presence tracker that lets the bus skip snoops that can't do anything.
+ *
+ * In every snooping protocol a line in I ignores GETS, GETM and DATA, so a
+ * cache only has to snoop addresses it holds in some other state (including
+ * the transient ones, which is how a cache still sees its own request).
+ * Protocol_template reports every move out of and back into the initial state,
+ * which keeps the filter exact (inclusive of everything the caches hold).  The
+ * bus calls should_snoop before process_snoop_request and skips the call when
+ * it returns false.
+ *
+ * Filtered snoops don't show up in the per-state request counts or the
+ * transition coverage, since the protocol never sees them.
+ */
+class Snoop_filter
+{
+public:
+    Snoop_filter ();
+
+    /** Off by default; set before the first request when using a snooping bus */
+    bool enabled;
+
+    /** Called by Protocol_template when core's copy of addr leaves I */
+    void line_valid (paddr_t addr, int core);
+    /** Called by Protocol_template when core's copy of addr goes back to I */
+    void line_invalid (paddr_t addr, int core);
+
+    /** False if core's copy of addr is in I and the snoop can be skipped */
+    inline bool should_snoop (paddr_t addr, int core)
+    {
+        if (!enabled || core >= SNOOP_FILTER_MAX_CORES)
+            return true;
+        if ((slots[find (addr)].holders >> core) & 1)
+            return true;
+        Stats.core (core).snoops_filtered++;
+        return false;
+    }
+
+private:
+    struct Slot
+    {
+        paddr_t addr;
+        /** Bit per core that holds the line in a state other than I */
+        unsigned long long holders;
+        bool used;
+    };
+
+    /** Open addressing with linear probing.  Slots are never freed, a line
+     * nobody holds just has no holders left.
+     */
+    std::vector<Slot> slots;
+    unsigned int used;
+    /** slots.size () is 1 << bits */
+    unsigned int bits;
+
+    /** Index of addr's slot, or of the empty slot where it would go */
+    inline unsigned int find (paddr_t addr)
+    {
+        unsigned int mask = slots.size () - 1;
+        unsigned int i = line_hash (addr, bits);
+        while (slots[i].used && slots[i].addr != addr)
+            i = (i + 1) & mask;
+        return i;
+    }
+
+    void grow ();
+};
+
+/** There is one filter for the bus */
+extern Snoop_filter Snoop_presence;
+
+#endif /* SNOOP_FILTER_H_ */
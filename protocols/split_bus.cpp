@@ -0,0 +1,200 @@
+#include "split_bus.h"
+#include "messages.h"
+
+Split_bus Split_transactions;
+
+Split_bus::Split_bus ()
+    : enabled (false), max_outstanding (8), reorder (false),
+      transactions (0), max_in_flight (0), refused_full (0), refused_conflict (0),
+      refused_order (0), reordered (0), request_cycles (0), response_cycles (0),
+      response_wait_cycles (0), in_flight (0), next_seq (0)
+{
+}
+
+void Split_bus::open (paddr_t addr, ModuleID requester, unsigned long long now)
+{
+    if (!enabled)
+        return;
+
+    Transaction *t = find (addr, requester, PHASE_FREE);
+
+    if (!t) {
+        Transaction empty;
+        empty.phase = PHASE_FREE;
+        table.push_back (empty);
+        t = &table.back ();
+    }
+    t->addr = addr;
+    t->requester = requester;
+    t->phase = PHASE_REQUEST;
+    t->response_ready = false;
+    t->queued_at = now;
+}
+
+void Split_bus::ready (paddr_t addr, ModuleID requester, unsigned long long now)
+{
+    if (!enabled)
+        return;
+
+    Transaction *t = find (addr, requester, PHASE_RESPONSE);
+
+    if (t && !t->response_ready) {
+        t->response_ready = true;
+        t->ready_at = now;
+    }
+}
+
+/** With PHASE_FREE, any free entry */
+Split_bus::Transaction *Split_bus::find (paddr_t addr, ModuleID requester, unsigned char phase)
+{
+    for (unsigned int i = 0; i < table.size (); i++) {
+        Transaction &t = table[i];
+        if (t.phase != phase)
+            continue;
+        if (phase == PHASE_FREE || (t.addr == addr && t.requester == requester))
+            return &t;
+    }
+    return NULL;
+}
+
+bool Split_bus::line_busy (paddr_t addr)
+{
+    for (unsigned int i = 0; i < table.size (); i++)
+        if (table[i].phase == PHASE_RESPONSE && table[i].addr == addr)
+            return true;
+    return false;
+}
+
+unsigned long long Split_bus::oldest ()
+{
+    unsigned long long seq = next_seq;
+
+    for (unsigned int i = 0; i < table.size (); i++)
+        if (table[i].phase == PHASE_RESPONSE && table[i].seq < seq)
+            seq = table[i].seq;
+    return seq;
+}
+
+bool Split_bus::can_grant (Mreq *request)
+{
+    if (!enabled)
+        return true;
+
+    switch (request->msg) {
+    case DATA:
+    case DATA_EXCL: {
+        if (reorder)
+            return true;
+        Transaction *t = find (request->addr, request->dest_mid, PHASE_RESPONSE);
+        if (t && t->seq != oldest ()) {
+            refused_order++;
+            return false;
+        }
+        return true;
+    }
+    case GETS:
+    case GETM:
+        if (in_flight >= max_outstanding) {
+            refused_full++;
+            return false;
+        }
+        /* Fall through */
+    case UPGRADE:
+    case PUTM:
+    case UPDATE:
+        if (line_busy (request->addr)) {
+            refused_conflict++;
+            return false;
+        }
+        return true;
+    default:
+        return true;
+    }
+}
+
+void Split_bus::granted (Mreq *request, unsigned long long now)
+{
+    Transaction *t;
+
+    if (!enabled)
+        return;
+
+    switch (request->msg) {
+    case GETS:
+    case GETM:
+        t = find (request->addr, request->src_mid, PHASE_REQUEST);
+        if (!t)
+            return;
+        t->phase = PHASE_RESPONSE;
+        t->seq = next_seq++;
+        t->granted_at = now;
+        request_cycles += now - t->queued_at;
+        if (++in_flight > max_in_flight)
+            max_in_flight = in_flight;
+        break;
+    case DATA:
+    case DATA_EXCL:
+        t = find (request->addr, request->dest_mid, PHASE_RESPONSE);
+        if (!t)
+            return;
+        if (t->seq != oldest ())
+            reordered++;
+        response_cycles += now - t->granted_at;
+        if (t->response_ready)
+            response_wait_cycles += now - t->ready_at;
+        t->phase = PHASE_FREE;
+        in_flight--;
+        transactions++;
+        break;
+    default:
+        break;
+    }
+}
+
+void Split_bus::dump_stats ()
+{
+    if (!enabled)
+        return;
+
+    fprintf (stderr, "Split bus transactions: %llu\n", transactions);
+    fprintf (stderr, "Split bus max in flight: %u of %u\n", max_in_flight, max_outstanding);
+    fprintf (stderr, "Split bus refused: %llu full, %llu same line, %llu out of order\n",
+             refused_full, refused_conflict, refused_order);
+    fprintf (stderr, "Split bus reordered responses: %llu\n", reordered);
+    fprintf (stderr, "Split bus request phase: %.2f cycles average\n",
+             transactions ? (double) request_cycles / transactions : 0.0);
+    fprintf (stderr, "Split bus response phase: %.2f cycles average, %.2f waiting for the bus\n",
+             transactions ? (double) response_cycles / transactions : 0.0,
+             transactions ? (double) response_wait_cycles / transactions : 0.0);
+}
+
+void Split_bus::write_json (FILE *f)
+{
+    fprintf (f, "  \"split_bus\": {\n");
+    fprintf (f, "      \"enabled\": %s,\n", enabled ? "true" : "false");
+    fprintf (f, "      \"max_outstanding\": %u,\n", max_outstanding);
+    fprintf (f, "      \"reorder\": %s,\n", reorder ? "true" : "false");
+    fprintf (f, "      \"transactions\": %llu,\n", transactions);
+    fprintf (f, "      \"max_in_flight\": %u,\n", max_in_flight);
+    fprintf (f, "      \"refused_full\": %llu,\n", refused_full);
+    fprintf (f, "      \"refused_conflict\": %llu,\n", refused_conflict);
+    fprintf (f, "      \"refused_order\": %llu,\n", refused_order);
+    fprintf (f, "      \"reordered\": %llu,\n", reordered);
+    fprintf (f, "      \"request_cycles\": %llu,\n", request_cycles);
+    fprintf (f, "      \"response_cycles\": %llu,\n", response_cycles);
+    fprintf (f, "      \"response_wait_cycles\": %llu\n", response_wait_cycles);
+    fprintf (f, "  },\n");
+}
+
+void Split_bus::write_csv (FILE *f)
+{
+    fprintf (f, "split_bus,transactions,,%llu\n", transactions);
+    fprintf (f, "split_bus,max_in_flight,,%u\n", max_in_flight);
+    fprintf (f, "split_bus,refused,full,%llu\n", refused_full);
+    fprintf (f, "split_bus,refused,conflict,%llu\n", refused_conflict);
+    fprintf (f, "split_bus,refused,order,%llu\n", refused_order);
+    fprintf (f, "split_bus,reordered,,%llu\n", reordered);
+    fprintf (f, "split_bus,request_cycles,,%llu\n", request_cycles);
+    fprintf (f, "split_bus,response_cycles,,%llu\n", response_cycles);
+    fprintf (f, "split_bus,response_wait_cycles,,%llu\n", response_wait_cycles);
+}
@@ -0,0 +1,122 @@
+#ifndef SPLIT_BUS_H_
+#define SPLIT_BUS_H_
+
+#include <stdio.h>
+#include <vector>
+#include "../sim/types.h"
+#include "../sim/module.h"
+#include "../sim/mreq.h"
+
+/** Split-transaction mode for the snooping bus.
+ *
+ * The atomic bus holds the bus from a GETS/GETM until its DATA, so every
+ * request behind it waits out the memory latency.  In split mode a GETS/GETM
+ * only holds the bus for its request phase; the DATA answering it is a
+ * separate response phase that arbitrates like any other message.  Up to
+ * max_outstanding transactions may be between the two phases.
+ *
+ * Protocol::send_GETS/send_GETM open a transaction when they queue the
+ * request and send_DATA_on_bus marks its response as ready.  The bus asks
+ * can_grant() before it picks a message, skipping the ones refused, and
+ * calls granted() once it has picked one; it calls response() itself when
+ * the memory controller queues DATA.  can_grant() refuses
+ *     a GETS/GETM while max_outstanding transactions wait for a response,
+ *     any broadcast for a line that has a transaction waiting for a response,
+ *         so a transient state never sees another cache's request between its
+ *         own request and its DATA, and the tables need no new rows,
+ *     unless reorder is set, a response other than the oldest transaction's.
+ * Everything else (UPGRADE, writebacks, the directory's point-to-point
+ * traffic) is always granted.
+ *
+ * Nothing in this tree calls can_grant() or granted() yet; the bus in sim/
+ * has to before anything sets enabled.  Until then leave it off: the bus is
+ * atomic, every hook returns at once and no transaction is ever opened.
+ */
+class Split_bus
+{
+public:
+    Split_bus ();
+
+    bool enabled;
+    /** Transactions allowed between their request and response phases */
+    unsigned int max_outstanding;
+    /** Responses may complete in any order, not only oldest first */
+    bool reorder;
+
+    /** requester queued a GETS/GETM for addr */
+    inline void request (paddr_t addr, ModuleID requester, unsigned long long now)
+    {
+        if (enabled)
+            open (addr, requester, now);
+    }
+    /** DATA answering requester's transaction for addr is queued */
+    inline void response (paddr_t addr, ModuleID requester, unsigned long long now)
+    {
+        if (enabled)
+            ready (addr, requester, now);
+    }
+
+    /** False if the bus has to leave request in the queue for now */
+    bool can_grant (Mreq *request);
+    /** The bus picked request */
+    void granted (Mreq *request, unsigned long long now);
+
+    /** Completed transactions */
+    unsigned long long transactions;
+    unsigned int max_in_flight;
+    /** Arbitration rounds a message was refused in, by reason */
+    unsigned long long refused_full;
+    unsigned long long refused_conflict;
+    unsigned long long refused_order;
+    /** Responses granted while an older transaction was still waiting */
+    unsigned long long reordered;
+    /** Cycles from queueing a request to its grant, from the grant to the
+     * response's grant, and from the response being queued to its grant
+     */
+    unsigned long long request_cycles;
+    unsigned long long response_cycles;
+    unsigned long long response_wait_cycles;
+
+    void dump_stats ();
+    /** Writes "split_bus": {...} for the Stats export */
+    void write_json (FILE *f);
+    void write_csv (FILE *f);
+
+private:
+    typedef enum {
+        PHASE_FREE = 0,
+        PHASE_REQUEST,		// Queued for the request phase
+        PHASE_RESPONSE		// Request granted, waiting for its DATA
+    } phase_t;
+
+    struct Transaction
+    {
+        paddr_t addr;
+        ModuleID requester;
+        unsigned char phase;
+        bool response_ready;
+        /** Grant order of the request, the oldest response goes first */
+        unsigned long long seq;
+        unsigned long long queued_at;
+        unsigned long long granted_at;
+        unsigned long long ready_at;
+    };
+
+    /** A cache has one miss outstanding, so this only grows to the number of
+     * caches.  Free entries are reused.
+     */
+    std::vector<Transaction> table;
+    unsigned int in_flight;
+    unsigned long long next_seq;
+
+    void open (paddr_t addr, ModuleID requester, unsigned long long now);
+    void ready (paddr_t addr, ModuleID requester, unsigned long long now);
+    Transaction *find (paddr_t addr, ModuleID requester, unsigned char phase);
+    bool line_busy (paddr_t addr);
+    unsigned long long oldest ();
+};
+
+/** There is one bus */
+extern Split_bus Split_transactions;
+
+#endif /* SPLIT_BUS_H_ */
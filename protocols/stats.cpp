@@ -0,0 +1,324 @@
+#include <stdlib.h>
+#include <string.h>
+#include "stats.h"
+#include "mreq_pool.h"
+#include "bus_stats.h"
+#include "split_bus.h"
+#include "../sim/mreq.h"
+#include "../sim/sim.h"
+
+Stats_registry Stats;
+
+static void write_stats_at_exit (void)
+{
+    const char *path = getenv ("SIM_STATS");
+    Stats.finish (Global_Clock);
+    if (path && *path && !Stats.write (path))
+        fprintf (stderr, "Could not write stats to %s\n", path);
+}
+
+Core_stats::Core_stats ()
+{
+    cache_misses = 0;
+    silent_upgrades = 0;
+    cache_to_cache_transfers = 0;
+    snoops_filtered = 0;
+    evictions = 0;
+    l2_hits = 0;
+    llc_hits = 0;
+    memory_fills = 0;
+    back_invalidations = 0;
+    back_invalidations_deferred = 0;
+    updates_applied = 0;
+    data_transfers_saved = 0;
+    migrations_detected = 0;
+    migratory_handoffs = 0;
+    migratory_declassified = 0;
+    memset (latency, 0, sizeof (latency));
+    memset (latency_cycles, 0, sizeof (latency_cycles));
+    miss_pending = false;
+    miss_store = false;
+    miss_supplier = SUPPLIER_MEMORY;
+    miss_start = 0;
+    memset (requests, 0, sizeof (requests));
+    memset (sent, 0, sizeof (sent));
+    memset (state_requests, 0, sizeof (state_requests));
+    memset (transitions, 0, sizeof (transitions));
+    memset (occupancy, 0, sizeof (occupancy));
+    memset (lines_in_state, 0, sizeof (lines_in_state));
+    last_update = 0;
+}
+
+Stats_registry::Stats_registry ()
+{
+    protocol_name = "unknown";
+    state_names = NULL;
+    num_states = 0;
+    exit_registered = false;
+}
+
+Stats_registry::~Stats_registry ()
+{
+    for (unsigned int c = 0; c < cores.size (); c++)
+        delete cores[c];
+}
+
+void Stats_registry::grow (unsigned int id)
+{
+    while (cores.size () <= id)
+        cores.push_back (new Core_stats ());
+}
+
+void Stats_registry::set_protocol (const char *name, const char *const *state_names, unsigned int num_states)
+{
+    if (name == protocol_name)
+        return;
+
+    /* Registered on first use rather than at static construction so everything
+     * the export reads is still alive when it runs
+     */
+    if (!exit_registered && getenv ("SIM_STATS")) {
+        atexit (write_stats_at_exit);
+        exit_registered = true;
+    }
+
+    this->protocol_name = name;
+    this->state_names = state_names;
+    this->num_states = num_states < STATS_MAX_STATES ? num_states : STATS_MAX_STATES;
+}
+
+void Stats_registry::finish (unsigned long long now)
+{
+    for (unsigned int c = 0; c < cores.size (); c++)
+        cores[c]->advance (now);
+}
+
+const char *Stats_registry::state_name (unsigned int state)
+{
+    return state < num_states ? state_names[state] : "?";
+}
+
+bool Stats_registry::write (const char *path)
+{
+    FILE *f = fopen (path, "w");
+    if (!f)
+        return false;
+
+    size_t len = strlen (path);
+    if (len > 4 && strcmp (path + len - 4, ".csv") == 0)
+        write_csv (f);
+    else
+        write_json (f);
+
+    return fclose (f) == 0;
+}
+
+/** Writes "name": {"key": value, ...} for one array of counters */
+static void json_counters (FILE *f, const char *name, const unsigned long long *values,
+                           const char *const *keys, unsigned int n)
+{
+    fprintf (f, "      \"%s\": {", name);
+    for (unsigned int i = 0; i < n; i++)
+        fprintf (f, "%s\"%s\": %llu", i ? ", " : "", keys[i], values[i]);
+    fprintf (f, "}");
+}
+
+static const char *const latency_requests[2] = {"LOAD", "STORE"};
+static const char *const supplier_names[SUPPLIER_NUM] = {"memory", "owner", "forwarder", "none"};
+
+/** Writes the miss latency histograms, each cut after its last non-zero bucket */
+static void json_latency (FILE *f, const Core_stats &s)
+{
+    fprintf (f, "      \"latency\": {");
+    for (int r = 0; r < 2; r++) {
+        fprintf (f, "%s\n        \"%s\": {", r ? "," : "", latency_requests[r]);
+        for (int sup = 0; sup < SUPPLIER_NUM; sup++) {
+            int last = LATENCY_BUCKETS;
+            while (last > 0 && !s.latency[r][sup][last - 1])
+                last--;
+            fprintf (f, "%s\"%s\": {\"cycles\": %llu, \"buckets\": [", sup ? ", " : "",
+                     supplier_names[sup], s.latency_cycles[r][sup]);
+            for (int b = 0; b < last; b++)
+                fprintf (f, "%s%llu", b ? ", " : "", s.latency[r][sup][b]);
+            fprintf (f, "]}");
+        }
+        fprintf (f, "}");
+    }
+    fprintf (f, "\n      }");
+}
+
+/** Writes the non-zero entries of the transition coverage as a list */
+void Stats_registry::json_transitions (FILE *f, const Core_stats &s)
+{
+    bool first = true;
+
+    fprintf (f, "      \"transitions\": [");
+    for (unsigned int st = 0; st < num_states; st++)
+        for (int m = 0; m < MREQ_MESSAGE_NUM; m++)
+            for (unsigned int n = 0; n < num_states; n++) {
+                if (!s.transitions[st][m][n])
+                    continue;
+                fprintf (f, "%s\n        {\"from\": \"%s\", \"msg\": \"%s\", \"to\": \"%s\", \"count\": %llu}",
+                         first ? "" : ",", state_name (st), Mreq::message_t_str[m], state_name (n),
+                         s.transitions[st][m][n]);
+                first = false;
+            }
+    fprintf (f, "%s]", first ? "" : "\n      ");
+}
+
+void Stats_registry::write_json (FILE *f)
+{
+    Core_stats total;
+
+    fprintf (f, "{\n");
+    fprintf (f, "  \"protocol\": \"%s\",\n", protocol_name);
+    fprintf (f, "  \"cores\": [\n");
+    for (unsigned int c = 0; c < cores.size (); c++) {
+        Core_stats &s = *cores[c];
+
+        total.cache_misses += s.cache_misses;
+        total.silent_upgrades += s.silent_upgrades;
+        total.cache_to_cache_transfers += s.cache_to_cache_transfers;
+        total.snoops_filtered += s.snoops_filtered;
+        total.evictions += s.evictions;
+        total.l2_hits += s.l2_hits;
+        total.llc_hits += s.llc_hits;
+        total.memory_fills += s.memory_fills;
+        total.back_invalidations += s.back_invalidations;
+        total.back_invalidations_deferred += s.back_invalidations_deferred;
+        total.updates_applied += s.updates_applied;
+        total.data_transfers_saved += s.data_transfers_saved;
+        total.migrations_detected += s.migrations_detected;
+        total.migratory_handoffs += s.migratory_handoffs;
+        total.migratory_declassified += s.migratory_declassified;
+        for (int r = 0; r < 2; r++)
+            for (int sup = 0; sup < SUPPLIER_NUM; sup++) {
+                total.latency_cycles[r][sup] += s.latency_cycles[r][sup];
+                for (int b = 0; b < LATENCY_BUCKETS; b++)
+                    total.latency[r][sup][b] += s.latency[r][sup][b];
+            }
+        for (int m = 0; m < MREQ_MESSAGE_NUM; m++) {
+            total.requests[m] += s.requests[m];
+            total.sent[m] += s.sent[m];
+        }
+        for (int st = 0; st < STATS_MAX_STATES; st++) {
+            total.state_requests[st] += s.state_requests[st];
+            total.occupancy[st] += s.occupancy[st];
+            for (int m = 0; m < MREQ_MESSAGE_NUM; m++)
+                for (int n = 0; n < STATS_MAX_STATES; n++)
+                    total.transitions[st][m][n] += s.transitions[st][m][n];
+        }
+
+        fprintf (f, "    {\n");
+        fprintf (f, "      \"id\": %u,\n", c);
+        fprintf (f, "      \"cache_misses\": %llu,\n", s.cache_misses);
+        fprintf (f, "      \"silent_upgrades\": %llu,\n", s.silent_upgrades);
+        fprintf (f, "      \"cache_to_cache_transfers\": %llu,\n", s.cache_to_cache_transfers);
+        fprintf (f, "      \"snoops_filtered\": %llu,\n", s.snoops_filtered);
+        fprintf (f, "      \"evictions\": %llu,\n", s.evictions);
+        fprintf (f, "      \"l2_hits\": %llu,\n", s.l2_hits);
+        fprintf (f, "      \"llc_hits\": %llu,\n", s.llc_hits);
+        fprintf (f, "      \"memory_fills\": %llu,\n", s.memory_fills);
+        fprintf (f, "      \"back_invalidations\": %llu,\n", s.back_invalidations);
+        fprintf (f, "      \"back_invalidations_deferred\": %llu,\n", s.back_invalidations_deferred);
+        fprintf (f, "      \"updates_applied\": %llu,\n", s.updates_applied);
+        fprintf (f, "      \"data_transfers_saved\": %llu,\n", s.data_transfers_saved);
+        fprintf (f, "      \"migrations_detected\": %llu,\n", s.migrations_detected);
+        fprintf (f, "      \"migratory_handoffs\": %llu,\n", s.migratory_handoffs);
+        fprintf (f, "      \"migratory_declassified\": %llu,\n", s.migratory_declassified);
+        json_counters (f, "requests", s.requests, Mreq::message_t_str, MREQ_MESSAGE_NUM);
+        fprintf (f, ",\n");
+        json_counters (f, "sent", s.sent, Mreq::message_t_str, MREQ_MESSAGE_NUM);
+        fprintf (f, ",\n");
+        json_counters (f, "state_requests", s.state_requests, state_names, num_states);
+        fprintf (f, ",\n");
+        json_counters (f, "occupancy", s.occupancy, state_names, num_states);
+        fprintf (f, ",\n");
+        json_latency (f, s);
+        fprintf (f, ",\n");
+        json_transitions (f, s);
+        fprintf (f, "\n    }%s\n", c + 1 < cores.size () ? "," : "");
+    }
+    fprintf (f, "  ],\n");
+
+    fprintf (f, "  \"totals\": {\n");
+    fprintf (f, "      \"cache_misses\": %llu,\n", total.cache_misses);
+    fprintf (f, "      \"silent_upgrades\": %llu,\n", total.silent_upgrades);
+    fprintf (f, "      \"cache_to_cache_transfers\": %llu,\n", total.cache_to_cache_transfers);
+    fprintf (f, "      \"snoops_filtered\": %llu,\n", total.snoops_filtered);
+    fprintf (f, "      \"evictions\": %llu,\n", total.evictions);
+    fprintf (f, "      \"l2_hits\": %llu,\n", total.l2_hits);
+    fprintf (f, "      \"llc_hits\": %llu,\n", total.llc_hits);
+    fprintf (f, "      \"memory_fills\": %llu,\n", total.memory_fills);
+    fprintf (f, "      \"back_invalidations\": %llu,\n", total.back_invalidations);
+    fprintf (f, "      \"back_invalidations_deferred\": %llu,\n", total.back_invalidations_deferred);
+    fprintf (f, "      \"updates_applied\": %llu,\n", total.updates_applied);
+    fprintf (f, "      \"data_transfers_saved\": %llu,\n", total.data_transfers_saved);
+    fprintf (f, "      \"migrations_detected\": %llu,\n", total.migrations_detected);
+    fprintf (f, "      \"migratory_handoffs\": %llu,\n", total.migratory_handoffs);
+    fprintf (f, "      \"migratory_declassified\": %llu,\n", total.migratory_declassified);
+    json_counters (f, "requests", total.requests, Mreq::message_t_str, MREQ_MESSAGE_NUM);
+    fprintf (f, ",\n");
+    json_counters (f, "sent", total.sent, Mreq::message_t_str, MREQ_MESSAGE_NUM);
+    fprintf (f, ",\n");
+    json_counters (f, "state_requests", total.state_requests, state_names, num_states);
+    fprintf (f, ",\n");
+    json_counters (f, "occupancy", total.occupancy, state_names, num_states);
+    fprintf (f, ",\n");
+    json_latency (f, total);
+    fprintf (f, ",\n");
+    json_transitions (f, total);
+    fprintf (f, "\n  },\n");
+
+    Bus_usage.write_json (f);
+    Split_transactions.write_json (f);
+    fprintf (f, "  \"mreq_pool\": {\"allocations\": %llu, \"allocations_avoided\": %llu}\n",
+             Mreq_allocator.allocations, Mreq_allocator.allocations_avoided);
+    fprintf (f, "}\n");
+}
+
+void Stats_registry::write_csv (FILE *f)
+{
+    fprintf (f, "core,counter,key,value\n");
+    for (unsigned int c = 0; c < cores.size (); c++) {
+        Core_stats &s = *cores[c];
+
+        fprintf (f, "%u,cache_misses,,%llu\n", c, s.cache_misses);
+        fprintf (f, "%u,silent_upgrades,,%llu\n", c, s.silent_upgrades);
+        fprintf (f, "%u,cache_to_cache_transfers,,%llu\n", c, s.cache_to_cache_transfers);
+        fprintf (f, "%u,snoops_filtered,,%llu\n", c, s.snoops_filtered);
+        fprintf (f, "%u,evictions,,%llu\n", c, s.evictions);
+        fprintf (f, "%u,l2_hits,,%llu\n", c, s.l2_hits);
+        fprintf (f, "%u,llc_hits,,%llu\n", c, s.llc_hits);
+        fprintf (f, "%u,memory_fills,,%llu\n", c, s.memory_fills);
+        fprintf (f, "%u,back_invalidations,,%llu\n", c, s.back_invalidations);
+        fprintf (f, "%u,back_invalidations_deferred,,%llu\n", c, s.back_invalidations_deferred);
+        fprintf (f, "%u,updates_applied,,%llu\n", c, s.updates_applied);
+        fprintf (f, "%u,data_transfers_saved,,%llu\n", c, s.data_transfers_saved);
+        fprintf (f, "%u,migrations_detected,,%llu\n", c, s.migrations_detected);
+        fprintf (f, "%u,migratory_handoffs,,%llu\n", c, s.migratory_handoffs);
+        fprintf (f, "%u,migratory_declassified,,%llu\n", c, s.migratory_declassified);
+        for (int m = 0; m < MREQ_MESSAGE_NUM; m++)
+            fprintf (f, "%u,requests,%s,%llu\n", c, Mreq::message_t_str[m], s.requests[m]);
+        for (int m = 0; m < MREQ_MESSAGE_NUM; m++)
+            fprintf (f, "%u,sent,%s,%llu\n", c, Mreq::message_t_str[m], s.sent[m]);
+        for (unsigned int st = 0; st < num_states; st++)
+            fprintf (f, "%u,state_requests,%s,%llu\n", c, state_name (st), s.state_requests[st]);
+        for (unsigned int st = 0; st < num_states; st++)
+            fprintf (f, "%u,occupancy,%s,%llu\n", c, state_name (st), s.occupancy[st]);
+        for (int r = 0; r < 2; r++)
+            for (int sup = 0; sup < SUPPLIER_NUM; sup++)
+                for (int b = 0; b < LATENCY_BUCKETS; b++)
+                    if (s.latency[r][sup][b])
+                        fprintf (f, "%u,latency,%s/%s/%d,%llu\n", c, latency_requests[r],
+                                 supplier_names[sup], b, s.latency[r][sup][b]);
+        for (unsigned int st = 0; st < num_states; st++)
+            for (int m = 0; m < MREQ_MESSAGE_NUM; m++)
+                for (unsigned int n = 0; n < num_states; n++)
+                    if (s.transitions[st][m][n])
+                        fprintf (f, "%u,transition,%s/%s/%s,%llu\n", c, state_name (st),
+                                 Mreq::message_t_str[m], state_name (n), s.transitions[st][m][n]);
+    }
+    Bus_usage.write_csv (f);
+    Split_transactions.write_csv (f);
+}
@@ -0,0 +1,210 @@
+#ifndef STATS_H_
+#define STATS_H_
+
+#include <stdio.h>
+#include <vector>
+#include "messages.h"
+
+/** Build with -DNO_STATS to compile out the counting done on every request:
+ * the request and state counts, the miss latency histograms and, through
+ * NO_COVERAGE, transition coverage and occupancy.  The counters bumped by the
+ * rarer actions (misses, messages sent, evictions) are kept.
+ */
+#ifdef NO_STATS
+#ifndef NO_COVERAGE
+#define NO_COVERAGE
+#endif
+#endif
+
+/** Largest number of states (including the unused 0 entry) of any protocol */
+#define STATS_MAX_STATES 16
+
+/** Log2 buckets of the miss latency histograms */
+#define LATENCY_BUCKETS 32
+
+/** Where the data for a miss came from */
+typedef enum {
+    SUPPLIER_MEMORY = 0,	// Memory, the directory or an outer cache level
+    SUPPLIER_OWNER,		// Another cache holding the line dirty (M, O)
+    SUPPLIER_FORWARDER,	// Another cache holding the line clean (E, F)
+    SUPPLIER_NONE,		// Granted UPGRADE, the data was already here
+    SUPPLIER_NUM
+} supplier_t;
+
+/** Counters kept for every cache */
+class Core_stats
+{
+public:
+    Core_stats ();
+
+    unsigned long long cache_misses;
+    unsigned long long silent_upgrades;
+    unsigned long long cache_to_cache_transfers;
+    /** Bus snoops skipped because the line was in I, see snoop_filter.h */
+    unsigned long long snoops_filtered;
+    /** Valid lines replaced in a capacity-limited cache, see cache_array.h */
+    unsigned long long evictions;
+    /** Where misses no other cache supplied were served, see cache_hierarchy.h */
+    unsigned long long l2_hits;
+    unsigned long long llc_hits;
+    unsigned long long memory_fills;
+    unsigned long long back_invalidations;
+    /** Back-invalidations of a line with a request in flight, carried out when it completed */
+    unsigned long long back_invalidations_deferred;
+    /** Another cache's write merged into a copy here (see UPDATE in messages.h),
+     * an invalidation protocol would have dropped the copy instead
+     */
+    unsigned long long updates_applied;
+    /** UPGRADEs that made a line writable without moving the data */
+    unsigned long long data_transfers_saved;
+    /** Migratory sharing, see migratory.h: lines this cache's write classified
+     * as migratory, GETS this cache answered by handing the line over in M, and
+     * handed-over lines this cache gave up before writing them
+     */
+    unsigned long long migrations_detected;
+    unsigned long long migratory_handoffs;
+    unsigned long long migratory_declassified;
+
+    /** Miss latency histograms, from the processor request to the data going to
+     * the processor, by request ([0] LOAD, [1] STORE) and supplier.  Bucket 0
+     * counts zero cycle misses, bucket b > 0 latencies in [2^(b-1), 2^b)
+     */
+    unsigned long long latency[2][SUPPLIER_NUM][LATENCY_BUCKETS];
+    unsigned long long latency_cycles[2][SUPPLIER_NUM];
+
+    /** The processor has one request outstanding per cache, this is its miss */
+    bool miss_pending;
+    bool miss_store;
+    unsigned char miss_supplier;
+    unsigned long long miss_start;
+
+    /** Requests handled by this cache, by message type */
+    unsigned long long requests[MREQ_MESSAGE_NUM];
+    /** Messages this cache put on the bus, by message type */
+    unsigned long long sent[MREQ_MESSAGE_NUM];
+    /** Requests handled while the line was in each state */
+    unsigned long long state_requests[STATS_MAX_STATES];
+
+    /** Transition coverage: how often [state][message] moved a line to [next state] */
+    unsigned long long transitions[STATS_MAX_STATES][MREQ_MESSAGE_NUM][STATS_MAX_STATES];
+
+    /** Time-weighted occupancy: sum over lines of the cycles spent in each state */
+    unsigned long long occupancy[STATS_MAX_STATES];
+    /** Lines currently in each state */
+    unsigned long long lines_in_state[STATS_MAX_STATES];
+    /** Cycle occupancy was last brought up to date */
+    unsigned long long last_update;
+
+    /** Accounts the cycles since the last update to the current states */
+    inline void advance (unsigned long long now)
+    {
+        if (now <= last_update)
+            return;
+        for (int s = 0; s < STATS_MAX_STATES; s++)
+            occupancy[s] += lines_in_state[s] * (now - last_update);
+        last_update = now;
+    }
+
+    inline void miss_started (message_t msg, unsigned long long now)
+    {
+        miss_pending = true;
+        miss_store = (msg == STORE);
+        miss_supplier = SUPPLIER_MEMORY;
+        miss_start = now;
+    }
+
+    /** Another cache sent the data for the miss, or none was needed */
+    inline void miss_supplied (supplier_t supplier)
+    {
+        if (miss_pending)
+            miss_supplier = supplier;
+    }
+
+    inline void miss_done (unsigned long long now)
+    {
+        if (!miss_pending)
+            return;
+        miss_pending = false;
+
+        unsigned long long cycles = now - miss_start;
+        int bucket = cycles ? 64 - __builtin_clzll (cycles) : 0;
+        if (bucket >= LATENCY_BUCKETS)
+            bucket = LATENCY_BUCKETS - 1;
+        latency[miss_store][miss_supplier][bucket]++;
+        latency_cycles[miss_store][miss_supplier] += cycles;
+    }
+
+    /** A new line starts out in state */
+    inline void line_added (unsigned char state, unsigned long long now)
+    {
+        advance (now);
+        lines_in_state[state]++;
+    }
+
+    /** A line left the cache in state */
+    inline void line_removed (unsigned char state, unsigned long long now)
+    {
+        advance (now);
+        lines_in_state[state]--;
+    }
+
+    inline void transition (unsigned char state, message_t msg, unsigned char next, unsigned long long now)
+    {
+#ifndef NO_COVERAGE
+        transitions[state][msg][next]++;
+        if (state != next) {
+            advance (now);
+            lines_in_state[state]--;
+            lines_in_state[next]++;
+        }
+#endif
+    }
+};
+
+/** Machine readable statistics.
+ *
+ * The protocols bump these alongside the Sim-> counters used for the text
+ * summary.  write() exports everything as JSON, or as CSV when the file name
+ * ends in .csv.  If the SIM_STATS environment variable names a file the stats
+ * are written there when the simulator exits.
+ */
+class Stats_registry
+{
+public:
+    Stats_registry ();
+    ~Stats_registry ();
+
+    /** The reference stays valid for the whole run, protocols keep it */
+    inline Core_stats &core (unsigned int id)
+    {
+        if (id >= cores.size ())
+            grow (id);
+        return *cores[id];
+    }
+
+    /** Called by every protocol so the export can name its states */
+    void set_protocol (const char *name, const char *const *state_names, unsigned int num_states);
+
+    /** Brings every core's occupancy up to now, call before writing */
+    void finish (unsigned long long now);
+
+    bool write (const char *path);
+    void write_json (FILE *f);
+    void write_csv (FILE *f);
+
+private:
+    std::vector<Core_stats *> cores;
+    const char *protocol_name;
+    const char *const *state_names;
+    unsigned int num_states;
+    bool exit_registered;
+
+    void grow (unsigned int id);
+    const char *state_name (unsigned int state);
+    void json_transitions (FILE *f, const Core_stats &s);
+};
+
+/** There is one registry for the whole simulation */
+extern Stats_registry Stats;
+
+#endif /* STATS_H_ */
@@ -0,0 +1,64 @@
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include "trace_log.h"
+#include "../sim/sim.h"
+
+log_level_t Trace_log::level = LOG_VALIDATION;
+char *Trace_log::buffer = NULL;
+
+void Trace_log::init (log_level_t level, const char *path, size_t buffer_size)
+{
+    Trace_log::level = level;
+
+    if (path && !freopen (path, "w", stderr))
+        fatal_error ("Could not open trace file\n");
+
+    /* setvbuf must come before anything is written to the stream, and only once */
+    if (buffer_size > 0 && !buffer) {
+        buffer = (char *) malloc (buffer_size);
+        if (buffer) {
+            setvbuf (stderr, buffer, _IOFBF, buffer_size);
+            atexit (Trace_log::flush);
+        }
+    }
+}
+
+void Trace_log::flush (void)
+{
+    fflush (stderr);
+}
+
+void Trace_log::fatal (const char *fmt, ...)
+{
+    char message[256];
+    va_list args;
+
+    va_start (args, fmt);
+    vsnprintf (message, sizeof (message), fmt, args);
+    va_end (args);
+
+    flush ();
+    fatal_error ("%s", message);
+}
+
+/** Runs init() at startup from SIM_LOG and SIM_LOG_FILE, see trace_log.h */
+static struct Trace_log_environment
+{
+    Trace_log_environment ()
+    {
+        const char *name = getenv ("SIM_LOG");
+        const char *path = getenv ("SIM_LOG_FILE");
+        log_level_t level = Trace_log::level;
+
+        if (!name && !path)
+            return;
+        if (name && !strcmp (name, "off"))
+            level = LOG_OFF;
+        else if (name && !strcmp (name, "summary"))
+            level = LOG_SUMMARY;
+        else if (name && !strcmp (name, "validation"))
+            level = LOG_VALIDATION;
+        Trace_log::init (level, path);
+    }
+} trace_log_environment;
@@ -0,0 +1,70 @@
+#ifndef TRACE_LOG_H_
+#define TRACE_LOG_H_
+
+#include <stdio.h>
+#include "../sim/module.h"
+#include "../sim/mreq.h"
+
+/** Verbosity of the simulation trace */
+typedef enum {
+    LOG_OFF = 0,		// Nothing but errors
+    LOG_SUMMARY,		// End of run statistics only
+    LOG_VALIDATION		// Full message trace, matches the validation runs
+} log_level_t;
+
+/** Buffered, leveled trace output.
+ *
+ * All trace messages (ours and the simulator's print_msg) go to stderr, so the
+ * buffering is done on stderr itself: one large user-space buffer flushed in
+ * blocks instead of an unbuffered write per line.  Since every writer shares the
+ * same stream the order of lines, and therefore the validation output, does not
+ * change.
+ *
+ * The simulator calls init() before the simulation starts.  Without that call
+ * the SIM_LOG (off, summary or validation) and SIM_LOG_FILE environment
+ * variables do the same at startup, like SIM_STATS does for the stats export.
+ * With neither, stderr is left unbuffered at LOG_VALIDATION.
+ *
+ * Build with -DNO_TRACE to compile the per-message trace out completely.
+ */
+class Trace_log
+{
+public:
+    /** Call once before the simulation starts.  If path is not NULL the trace
+     * is written to that file instead of stderr.
+     */
+    static void init (log_level_t level, const char *path = NULL,
+                      size_t buffer_size = DEFAULT_BUFFER_SIZE);
+    static void flush (void);
+
+    /** The per-message trace lines (the bus's SNOOP REQUEST, the processors'
+     * PROC REQUEST) are printed through here so they follow the level
+     */
+    static inline void print_msg (Mreq *request, ModuleID module, const char *what);
+
+    /** fatal_error for code that may have trace buffered: flushes it first so
+     * the lines leading up to the error aren't lost
+     */
+    static void fatal (const char *fmt, ...);
+
+    static log_level_t level;
+
+    static const size_t DEFAULT_BUFFER_SIZE = 1 << 20;
+
+private:
+    static char *buffer;
+};
+
+#ifdef NO_TRACE
+#define TRACE_ON(lvl) ((lvl) < LOG_VALIDATION && Trace_log::level >= (lvl))
+#else
+#define TRACE_ON(lvl) (Trace_log::level >= (lvl))
+#endif
+
+inline void Trace_log::print_msg (Mreq *request, ModuleID module, const char *what)
+{
+    if (TRACE_ON (LOG_VALIDATION))
+        request->print_msg (module, what);
+}
+
+#endif /* TRACE_LOG_H_ */
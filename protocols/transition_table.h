@@ -0,0 +1,100 @@
+#ifndef TRANSITION_TABLE_H_
+#define TRANSITION_TABLE_H_
+
+#include "messages.h"
+
+/**
+ * Generic transition table used by all of the protocols.
+ *
+ * Every protocol declares a table indexed by [state][message].  Processor
+ * requests (LOAD/STORE) and snooped or directory requests use disjoint
+ * message types, so one table covers both process_cache_request and
+ * process_snoop_request, and handling a request is a single indexed lookup.
+ */
+
+/** Actions a transition performs.  Protocol_template::transition applies them
+ * in the order they are listed here.
+ */
+typedef enum {
+    ACT_NONE           = 0,
+    ACT_SET_SHARED     = 1 << 0,	// set_shared_line()
+    ACT_SEND_GETS      = 1 << 1,	// send_GETS()
+    ACT_SEND_GETM      = 1 << 2,	// send_GETM()
+    ACT_SEND_UPGRADE   = 1 << 3,	// send_UPGRADE(), GETM without the data
+    ACT_SEND_DATA_BUS  = 1 << 4,	// send_DATA_on_bus() to the requester
+    ACT_SEND_DATA_DIR  = 1 << 5,	// send_DATA_to_dir(), writeback to the directory
+    ACT_SEND_INV_ACK   = 1 << 6,	// send_INV_ACK() to the directory
+    ACT_SEND_PUTM      = 1 << 7,	// send_PUTM(), write back an evicted dirty line
+    ACT_SEND_UPDATE    = 1 << 8,	// send_UPDATE(), broadcast a write to the other copies
+    ACT_SEND_DATA_PROC = 1 << 9,	// send_DATA_to_proc()
+    ACT_CACHE_MISS     = 1 << 10,	// Sim->cache_misses++
+    ACT_SILENT_UPGRADE = 1 << 11,	// Sim->silent_upgrades++
+    ACT_APPLY_UPDATE   = 1 << 12,	// Another cache's write was merged into this copy
+    ACT_DATA_SAVED     = 1 << 13,	// An UPGRADE completed without a DATA transfer
+    ACT_DECLASSIFY     = 1 << 14,	// Migratory_lines.declassify(), see migratory.h
+    ACT_ERROR          = 1 << 15	// This state should never see this message
+} transition_action_t;
+
+/** How the next state is chosen */
+typedef enum {
+    NEXT_ALWAYS = 0,	// Always go to next
+    NEXT_IF_SHARED,		// next if the shared line is set, alt otherwise
+    NEXT_IF_OTHER,		// next if someone else sent the request, stay otherwise
+    NEXT_IF_OWN_UPDATE,	// The sender's own broadcast: no actions, next.  Anyone else's:
+    					// the actions, then alt
+    NEXT_IF_UPDATE_SHARED,	// next if another cache kept its copy when this cache's last
+    					// UPDATE went out, alt otherwise
+    NEXT_IF_OWN,		// The sender's own broadcast: the actions, then next.  Anyone
+    					// else's: no actions, alt
+    NEXT_IF_MIGRATORY	// next if the line is migratory and gets handed over to the
+    					// requester (the data goes as DATA_EXCL), alt otherwise
+} transition_cond_t;
+
+typedef struct {
+    unsigned short actions;
+    unsigned char cond;
+    unsigned char next;
+    unsigned char alt;
+} Transition;
+
+/** Helpers for declaring tables.  Columns are in message_t order.  Entries left
+ * out at the end of a row are zero, and a next state of 0 (the unused state) is
+ * treated exactly like TRANS_ERROR, so a row only has to list the messages up
+ * to the last one the state handles.
+ */
+#define TRANS(actions, next)                { (actions), NEXT_ALWAYS, (next), (next) }
+#define TRANS_IF_SHARED(actions, next, alt) { (actions), NEXT_IF_SHARED, (next), (alt) }
+#define TRANS_IF_OTHER(actions, next, self) { (actions), NEXT_IF_OTHER, (next), (self) }
+/** Write-update protocols only learn whether a line is still shared once every
+ * cache has snooped their UPDATE, and the bus delivers it to the caches in node
+ * order, sender included.  So the sender's own UPDATE moves it to a state whose
+ * NOP entry is a TRANS_SETTLE, and Protocol_template settles that state with the
+ * next message for the line, after the last snoop (see update_sharing.h)
+ */
+#define TRANS_IF_OWN_UPDATE(actions, own, other) \
+    { (actions), NEXT_IF_OWN_UPDATE, (own), (other) }
+#define TRANS_SETTLE(shared, alone)         { ACT_NONE, NEXT_IF_UPDATE_SHARED, (shared), (alone) }
+/** A cache waiting for its own request to go out on the bus, e.g. an UPGRADE */
+#define TRANS_IF_OWN(actions, own, other)   { (actions), NEXT_IF_OWN, (own), (other) }
+/** Migratory sharing (see migratory.h): the M holder answers a GETS with
+ * TRANS_IF_MIGRATORY.  A hand over sends the data as DATA_EXCL, which is how
+ * the requester learns it gets the line in M
+ */
+#define TRANS_IF_MIGRATORY(actions, handover, keep) \
+    { (actions), NEXT_IF_MIGRATORY, (handover), (keep) }
+#define TRANS_ERROR                         { ACT_ERROR, NEXT_ALWAYS, 0, 0 }
+
+/** A row for a state that can never be entered (e.g. the unused 0 entry) */
+#define TRANS_ROW_INVALID { TRANS_ERROR }
+
+/** A table entry a run-time option switches between off and on, see e.g.
+ * MSI_protocol::set_upgrade.  Lists of them end with a zero state
+ */
+typedef struct {
+    unsigned char state;
+    unsigned char msg;
+    Transition off;
+    Transition on;
+} Transition_patch;
+
+#endif /* TRANSITION_TABLE_H_ */
@@ -0,0 +1,15 @@
+#include "update_sharing.h"
+
+Update_sharing Update_sharers;
+
+void Update_sharing::sent (paddr_t addr, int core)
+{
+    if ((unsigned int) core >= slots.size ()) {
+        Slot unused = {0, true, false};
+        slots.resize (core + 1, unused);
+    }
+    Slot &s = slots[core];
+    s.addr = addr;
+    s.shared = false;
+    s.used = true;
+}
@@ -0,0 +1,61 @@
+#ifndef UPDATE_SHARING_H_
+#define UPDATE_SHARING_H_
+
+#include <vector>
+#include "../sim/types.h"
+
+/** Whether anyone kept a copy of the line each cache last sent an UPDATE for.
+ *
+ * The bus delivers a broadcast to the caches in node order, the sender
+ * included, so when the sender snoops its own UPDATE the caches after it
+ * haven't asserted the shared line yet.  Instead every other cache that keeps
+ * its copy (or is about to fill one) records it here against the sender, and
+ * the sender reads the result when its next message for the line settles the
+ * state its UPDATE left it in (see TRANS_SETTLE), which is after every snoop.
+ *
+ * There is one slot per cache.  A slot holding another line, or one the
+ * sender never used, reads as shared, so a missed record only costs another
+ * UPDATE.
+ */
+class Update_sharing
+{
+public:
+    /** core queued an UPDATE for addr */
+    void sent (paddr_t addr, int core);
+
+    /** A cache other than sender kept its copy of addr when it snooped
+     * sender's UPDATE
+     */
+    inline void kept (paddr_t addr, int sender)
+    {
+        if ((unsigned int) sender < slots.size () && slots[sender].addr == addr)
+            slots[sender].shared = true;
+    }
+
+    /** True unless nobody kept a copy of addr when core's last UPDATE for it
+     * went out
+     */
+    inline bool shared (paddr_t addr, int core)
+    {
+        if ((unsigned int) core >= slots.size ())
+            return true;
+        const Slot &s = slots[core];
+        return !s.used || s.addr != addr || s.shared;
+    }
+
+private:
+    struct Slot
+    {
+        paddr_t addr;
+        bool shared;
+        bool used;
+    };
+
+    /** Indexed by core, grown by sent */
+    std::vector<Slot> slots;
+};
+
+/** There is one record for the bus */
+extern Update_sharing Update_sharers;
+
+#endif /* UPDATE_SHARING_H_ */
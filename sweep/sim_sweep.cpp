@@ -0,0 +1,279 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <spawn.h>
+#include <pthread.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <string>
+#include <vector>
+
+/**
+ * Runs every (protocol, trace) combination of a protocol comparison in
+ * parallel, so the full matrix takes as long as the slowest run instead of
+ * the sum of all of them.
+ *
+ * usage: sim_sweep [-j jobs] [-s sim_trace] [-o outdir] [-p MSI,MESI,...]
+ *                  [-g golden dir] <trace dir>...
+ *
+ * Each run is a separate sim_trace process (the simulator keeps its state in
+ * globals), with stdout and stderr going to <outdir>/<trace><PROTOCOL>_Validation.txt,
+ * the same naming as Piped Experiment Outputs.  A summary of every run is
+ * written to <outdir>/sweep_results.txt.
+ *
+ * With -g every output is compared against <golden dir>/<trace>/ (laid out like
+ * Piped Experiment Outputs).  The message trace (everything before "Simulation
+ * Finished") and the end of run summary are checked separately, and the
+ * results also get the simulated cycles per second and the peak RSS of each
+ * run.  A run with no golden output to compare against counts as a failure.
+ * Use -j 1 when the timings matter.
+ */
+
+extern char **environ;
+
+typedef struct {
+    std::string trace;
+    std::string protocol;
+    std::string output;
+    int status;
+    double seconds;
+    /** Peak resident set size in kilobytes, from wait4 */
+    long max_rss;
+    unsigned long long cycles;
+    /** Line of the first difference from the golden output, 0 if the same,
+     * -1 if there is no golden output (a failure with -g)
+     */
+    long trace_diff;
+    long summary_diff;
+} Sweep_run;
+
+static std::vector<Sweep_run> runs;
+static const char *sim_trace = "./sim_trace";
+static const char *golden_dir = NULL;
+static volatile int next_run = 0;
+
+static double now (void)
+{
+    struct timeval tv;
+    gettimeofday (&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+static std::string basename_of (const std::string &path)
+{
+    std::string p = path;
+    while (p.size () > 1 && p[p.size () - 1] == '/')
+        p.erase (p.size () - 1);
+    size_t slash = p.rfind ('/');
+    return slash == std::string::npos ? p : p.substr (slash + 1);
+}
+
+static void do_run (Sweep_run &run)
+{
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init (&actions);
+    posix_spawn_file_actions_addopen (&actions, STDOUT_FILENO, run.output.c_str (),
+                                      O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    posix_spawn_file_actions_adddup2 (&actions, STDOUT_FILENO, STDERR_FILENO);
+
+    char *argv[] = { (char *) sim_trace,
+                     (char *) "-t", (char *) run.trace.c_str (),
+                     (char *) "-p", (char *) run.protocol.c_str (),
+                     NULL };
+
+    double start = now ();
+    pid_t pid;
+    if (posix_spawn (&pid, sim_trace, &actions, NULL, argv, environ) != 0) {
+        run.status = -1;
+    } else {
+        int status;
+        struct rusage usage;
+        wait4 (pid, &status, 0, &usage);
+        run.status = WIFEXITED (status) ? WEXITSTATUS (status) : -1;
+        run.max_rss = usage.ru_maxrss;
+    }
+    run.seconds = now () - start;
+
+    posix_spawn_file_actions_destroy (&actions);
+}
+
+/** Reads the next line of f into line, without the newline.  False at EOF */
+static bool read_line (FILE *f, std::string &line)
+{
+    int c;
+
+    line.clear ();
+    while ((c = getc (f)) != EOF && c != '\n')
+        line += (char) c;
+    return c != EOF || !line.empty ();
+}
+
+/** Compares the output of run with its golden copy and picks up the run time */
+static void check_run (Sweep_run &run)
+{
+    FILE *out = fopen (run.output.c_str (), "r");
+    if (!out)
+        return;
+
+    std::string line;
+    FILE *golden = NULL;
+    if (golden_dir) {
+        std::string trace = basename_of (run.trace);
+        std::string path = std::string (golden_dir) + "/" + trace + "/" + trace
+                           + run.protocol + "_Validation.txt";
+        golden = fopen (path.c_str (), "r");
+    }
+
+    if (golden)
+        run.trace_diff = run.summary_diff = 0;
+
+    /* Walk both files in step, the summary starts at "Simulation Finished" */
+    long n = 0;
+    bool in_summary = false;
+    std::string expected;
+    for (;;) {
+        bool have = read_line (out, line);
+        bool have_expected = golden && read_line (golden, expected);
+        if (!have && !have_expected)
+            break;
+        n++;
+        if (have && line == "Simulation Finished")
+            in_summary = true;
+        if (have)
+            sscanf (line.c_str (), "Run Time: %llu cycles", &run.cycles);
+        if (golden && (have != have_expected || line != expected)) {
+            long &diff = in_summary ? run.summary_diff : run.trace_diff;
+            if (!diff)
+                diff = n;
+        }
+    }
+
+    if (golden)
+        fclose (golden);
+    fclose (out);
+}
+
+static const char *diff_str (long diff, char *buf)
+{
+    if (diff < 0)
+        return golden_dir ? "missing" : "-";
+    if (diff == 0)
+        return "same";
+    sprintf (buf, "line %ld", diff);
+    return buf;
+}
+
+static void *worker (void *arg)
+{
+    for (;;) {
+        int i = __sync_fetch_and_add (&next_run, 1);
+        if (i >= (int) runs.size ())
+            break;
+        do_run (runs[i]);
+        check_run (runs[i]);
+        fprintf (stderr, "%s: %s (%.2fs)\n", runs[i].output.c_str (),
+                 runs[i].status == 0 ? "done" : "FAILED", runs[i].seconds);
+    }
+    return NULL;
+}
+
+static void usage (const char *name)
+{
+    fprintf (stderr, "usage: %s [-j jobs] [-s sim_trace] [-o outdir] [-p MSI,MESI,...] "
+             "[-g golden dir] <trace dir>...\n", name);
+    exit (1);
+}
+
+int main (int argc, char *argv[])
+{
+    int jobs = sysconf (_SC_NPROCESSORS_ONLN);
+    std::string outdir = ".";
+    std::string protocols = "MSI,MESI,MOSI,MOESI,MOESIF";
+    int opt;
+
+    while ((opt = getopt (argc, argv, "j:s:o:p:g:")) != -1) {
+        switch (opt) {
+        case 'j': jobs = atoi (optarg); break;
+        case 's': sim_trace = optarg; break;
+        case 'o': outdir = optarg; break;
+        case 'p': protocols = optarg; break;
+        case 'g': golden_dir = optarg; break;
+        default: usage (argv[0]);
+        }
+    }
+    if (optind >= argc || jobs < 1)
+        usage (argv[0]);
+
+    for (int t = optind; t < argc; t++) {
+        size_t start = 0;
+        while (start <= protocols.size ()) {
+            size_t comma = protocols.find (',', start);
+            if (comma == std::string::npos)
+                comma = protocols.size ();
+            if (comma > start) {
+                Sweep_run run;
+                run.trace = argv[t];
+                run.protocol = protocols.substr (start, comma - start);
+                run.output = outdir + "/" + basename_of (run.trace) + run.protocol + "_Validation.txt";
+                run.status = -1;
+                run.seconds = 0;
+                run.max_rss = 0;
+                run.cycles = 0;
+                run.trace_diff = run.summary_diff = -1;
+                runs.push_back (run);
+            }
+            start = comma + 1;
+        }
+    }
+
+    if (jobs > (int) runs.size ())
+        jobs = runs.size ();
+
+    double start = now ();
+    std::vector<pthread_t> threads (jobs);
+    for (int i = 0; i < jobs; i++)
+        pthread_create (&threads[i], NULL, worker, NULL);
+    for (int i = 0; i < jobs; i++)
+        pthread_join (threads[i], NULL);
+    double total = now () - start;
+
+    std::string results = outdir + "/sweep_results.txt";
+    FILE *f = fopen (results.c_str (), "w");
+    if (!f) {
+        fprintf (stderr, "Could not write %s\n", results.c_str ());
+        return 1;
+    }
+
+    int failed = 0, mismatched = 0, missing = 0;
+    fprintf (f, "%-24s %-8s %-8s %10s %12s %14s %10s %-12s %-12s\n", "trace", "protocol",
+             "status", "seconds", "cycles", "cycles/s", "rss_kb", "trace", "summary");
+    for (size_t i = 0; i < runs.size (); i++) {
+        const Sweep_run &r = runs[i];
+        char tbuf[32], sbuf[32];
+        fprintf (f, "%-24s %-8s %-8d %10.3f %12llu %14.0f %10ld %-12s %-12s\n",
+                 basename_of (r.trace).c_str (), r.protocol.c_str (), r.status, r.seconds,
+                 r.cycles, r.seconds > 0 ? r.cycles / r.seconds : 0.0, r.max_rss,
+                 diff_str (r.trace_diff, tbuf), diff_str (r.summary_diff, sbuf));
+        if (r.status != 0)
+            failed++;
+        if (r.trace_diff > 0 || r.summary_diff > 0)
+            mismatched++;
+        /* A golden file that isn't there must not pass as a match */
+        if (golden_dir && r.status == 0 && r.trace_diff < 0)
+            missing++;
+    }
+    fprintf (f, "Total: %d runs, %d failed, %d differ from golden, %d without golden output, "
+             "%.3f seconds on %d jobs\n",
+             (int) runs.size (), failed, mismatched, missing, total, jobs);
+    fclose (f);
+
+    if (mismatched)
+        fprintf (stderr, "%d runs differ from %s, see %s\n", mismatched, golden_dir, results.c_str ());
+    if (missing)
+        fprintf (stderr, "%d runs have no golden output in %s, see %s\n", missing, golden_dir,
+                 results.c_str ());
+    return failed || mismatched || missing ? 1 : 0;
+}
@@ -0,0 +1,225 @@
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "binary_trace.h"
+
+/* Deltas are zigzag encoded and shifted left once for the op bit, so addresses
+ * have to fit in 62 bits.  Physical addresses are far smaller than that.
+ */
+#define MAX_ADDR_BITS 62
+
+/*************************
+ * Writer
+ *************************/
+Binary_trace_writer::Binary_trace_writer ()
+{
+    file = NULL;
+    index = NULL;
+    num_streams = 0;
+    cur_stream = -1;
+    last_addr = 0;
+    pos = 0;
+    error = false;
+}
+
+Binary_trace_writer::~Binary_trace_writer ()
+{
+    if (file)
+        close ();
+}
+
+bool Binary_trace_writer::open (const char *path, unsigned int num_streams)
+{
+    file = fopen (path, "wb");
+    if (!file)
+        return false;
+
+    this->num_streams = num_streams;
+    index = (Binary_trace_index *) calloc (num_streams, sizeof (Binary_trace_index));
+
+    /* The header and index are written for real in close () */
+    pos = sizeof (Binary_trace_header) + num_streams * sizeof (Binary_trace_index);
+    if (fseek (file, pos, SEEK_SET) != 0)
+        error = true;
+    return true;
+}
+
+void Binary_trace_writer::end_stream (void)
+{
+    if (cur_stream >= 0)
+        index[cur_stream].length = pos - index[cur_stream].offset;
+}
+
+void Binary_trace_writer::begin_stream (unsigned int stream)
+{
+    end_stream ();
+    if (stream >= num_streams) {
+        error = true;
+        return;
+    }
+    cur_stream = stream;
+    index[stream].offset = pos;
+    index[stream].count = 0;
+    last_addr = 0;
+}
+
+void Binary_trace_writer::add (const Trace_ref &ref)
+{
+    if (cur_stream < 0 || (ref.addr >> MAX_ADDR_BITS) != 0) {
+        error = true;
+        return;
+    }
+
+    long long delta = (long long) (ref.addr - last_addr);
+    unsigned long long zz = ((unsigned long long) delta << 1) ^ (unsigned long long) (delta >> 63);
+    unsigned long long v = (zz << 1) | (ref.op == 'w' ? 1 : 0);
+
+    unsigned char buf[10];
+    int n = 0;
+    do {
+        unsigned char byte = v & 0x7f;
+        v >>= 7;
+        if (v)
+            byte |= 0x80;
+        buf[n++] = byte;
+    } while (v);
+
+    if (fwrite (buf, 1, n, file) != (size_t) n)
+        error = true;
+    pos += n;
+    last_addr = ref.addr;
+    index[cur_stream].count++;
+}
+
+bool Binary_trace_writer::close (void)
+{
+    if (!file)
+        return false;
+
+    end_stream ();
+
+    Binary_trace_header header;
+    header.magic = BINARY_TRACE_MAGIC;
+    header.version = BINARY_TRACE_VERSION;
+    header.num_streams = num_streams;
+    header.reserved = 0;
+
+    if (fseek (file, 0, SEEK_SET) != 0
+        || fwrite (&header, sizeof (header), 1, file) != 1
+        || fwrite (index, sizeof (Binary_trace_index), num_streams, file) != num_streams)
+        error = true;
+
+    if (fclose (file) != 0)
+        error = true;
+    file = NULL;
+    free (index);
+    index = NULL;
+    cur_stream = -1;
+
+    return !error;
+}
+
+/*************************
+ * Reader
+ *************************/
+Binary_trace::Binary_trace ()
+{
+    fd = -1;
+    map = NULL;
+    map_size = 0;
+    num_streams = 0;
+    index = NULL;
+    cursors = NULL;
+}
+
+Binary_trace::~Binary_trace ()
+{
+    close ();
+}
+
+bool Binary_trace::open (const char *path)
+{
+    struct stat st;
+
+    fd = ::open (path, O_RDONLY);
+    if (fd < 0)
+        return false;
+    if (fstat (fd, &st) != 0 || (unsigned long long) st.st_size < sizeof (Binary_trace_header)) {
+        close ();
+        return false;
+    }
+
+    map_size = st.st_size;
+    void *m = mmap (NULL, map_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (m == MAP_FAILED) {
+        map = NULL;
+        close ();
+        return false;
+    }
+    map = (const unsigned char *) m;
+    /* References are decoded front to back */
+    madvise (m, map_size, MADV_SEQUENTIAL);
+
+    const Binary_trace_header *header = (const Binary_trace_header *) map;
+    if (header->magic != BINARY_TRACE_MAGIC || header->version != BINARY_TRACE_VERSION
+        || sizeof (Binary_trace_header) + header->num_streams * sizeof (Binary_trace_index) > map_size) {
+        close ();
+        return false;
+    }
+
+    num_streams = header->num_streams;
+    index = (const Binary_trace_index *) (map + sizeof (Binary_trace_header));
+    cursors = new Cursor[num_streams];
+    for (unsigned int i = 0; i < num_streams; i++) {
+        if (index[i].offset + index[i].length > map_size) {
+            close ();
+            return false;
+        }
+        cursors[i].ptr = map + index[i].offset;
+        cursors[i].end = cursors[i].ptr + index[i].length;
+        cursors[i].last_addr = 0;
+    }
+    return true;
+}
+
+void Binary_trace::close (void)
+{
+    delete [] cursors;
+    cursors = NULL;
+    if (map)
+        munmap ((void *) map, map_size);
+    map = NULL;
+    if (fd >= 0)
+        ::close (fd);
+    fd = -1;
+    num_streams = 0;
+    index = NULL;
+}
+
+bool Binary_trace::is_binary_trace (const char *path)
+{
+    unsigned int magic = 0;
+    FILE *f = fopen (path, "rb");
+    if (!f)
+        return false;
+    bool ok = fread (&magic, sizeof (magic), 1, f) == 1 && magic == BINARY_TRACE_MAGIC;
+    fclose (f);
+    return ok;
+}
+
+bool parse_trace_line (const char *line, Trace_ref *ref)
+{
+    char op;
+    unsigned long long addr;
+
+    if (sscanf (line, " %c %llx", &op, &addr) != 2)
+        return false;
+    if (op != 'r' && op != 'w')
+        return false;
+    ref->op = op;
+    ref->addr = addr;
+    return true;
+}
@@ -0,0 +1,131 @@
+#ifndef BINARY_TRACE_H_
+#define BINARY_TRACE_H_
+
+#include <stdio.h>
+#include "../sim/types.h"
+
+/**
+ * Compact binary trace format.
+ *
+ * A binary trace holds one stream per core.  Every reference is stored as a
+ * single varint: the zigzag encoded distance from the previous address of the
+ * same stream, shifted left by one, with the low bit set for writes.  Streams
+ * with locality therefore take one or two bytes per reference instead of a
+ * text line.
+ *
+ * Layout (host byte order):
+ *     Binary_trace_header
+ *     Binary_trace_index  x num_streams
+ *     stream data
+ */
+
+#define BINARY_TRACE_MAGIC   0x52544343	// "CCTR"
+#define BINARY_TRACE_VERSION 1
+
+typedef struct {
+    unsigned int magic;
+    unsigned int version;
+    unsigned int num_streams;
+    unsigned int reserved;
+} Binary_trace_header;
+
+typedef struct {
+    unsigned long long offset;	// From the start of the file
+    unsigned long long length;	// In bytes
+    unsigned long long count;	// Number of references
+} Binary_trace_index;
+
+/** One memory reference.  op is 'r' or 'w' like in the text traces */
+typedef struct {
+    char op;
+    paddr_t addr;
+} Trace_ref;
+
+/** Writes a binary trace one stream at a time */
+class Binary_trace_writer
+{
+public:
+    Binary_trace_writer ();
+    ~Binary_trace_writer ();
+
+    bool open (const char *path, unsigned int num_streams);
+    /** Streams must be written in order, begin_stream (0), add..., begin_stream (1)... */
+    void begin_stream (unsigned int stream);
+    void add (const Trace_ref &ref);
+    /** Writes the index.  Returns false if anything failed to write */
+    bool close (void);
+
+private:
+    FILE *file;
+    unsigned int num_streams;
+    int cur_stream;
+    paddr_t last_addr;
+    unsigned long long pos;
+    Binary_trace_index *index;
+    bool error;
+
+    void end_stream (void);
+};
+
+/** Reads a binary trace through mmap, no parsing at startup */
+class Binary_trace
+{
+public:
+    Binary_trace ();
+    ~Binary_trace ();
+
+    /** Returns false if the file can't be mapped or isn't a binary trace */
+    bool open (const char *path);
+    void close (void);
+
+    unsigned int get_num_streams (void) { return num_streams; }
+    unsigned long long get_count (unsigned int stream) { return index[stream].count; }
+
+    /** Decodes the next reference of stream.  Returns false at the end of the stream */
+    inline bool next (unsigned int stream, Trace_ref *ref)
+    {
+        Cursor &c = cursors[stream];
+        if (c.ptr == c.end)
+            return false;
+
+        unsigned long long v = 0;
+        int shift = 0;
+        unsigned char byte;
+        do {
+            byte = *c.ptr++;
+            v |= (unsigned long long) (byte & 0x7f) << shift;
+            shift += 7;
+        } while ((byte & 0x80) && c.ptr != c.end);
+
+        ref->op = (v & 1) ? 'w' : 'r';
+        v >>= 1;
+        long long delta = (long long) (v >> 1) ^ -(long long) (v & 1);
+        c.last_addr += delta;
+        ref->addr = c.last_addr;
+        return true;
+    }
+
+    /** Returns true if path starts with the binary trace magic */
+    static bool is_binary_trace (const char *path);
+
+private:
+    struct Cursor {
+        const unsigned char *ptr;
+        const unsigned char *end;
+        paddr_t last_addr;
+    };
+
+    int fd;
+    const unsigned char *map;
+    unsigned long long map_size;
+    unsigned int num_streams;
+    const Binary_trace_index *index;
+    Cursor *cursors;
+};
+
+/** Parses one line of a text trace ("r 0xdeadbeef").  Returns false on a blank
+ * or malformed line.
+ */
+bool parse_trace_line (const char *line, Trace_ref *ref);
+
+#endif /* BINARY_TRACE_H_ */
@@ -0,0 +1,265 @@
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+#include "compressed_trace.h"
+
+/** References moved into a ring before the thread looks at the next stream */
+#define FILL_BATCH 1024
+
+/*************************
+ * Line sources
+ *************************/
+class Trace_source
+{
+public:
+    virtual ~Trace_source () {}
+    /** Returns false at the end of the file */
+    virtual bool read_line (char *buf, int len) = 0;
+};
+
+/** gzip files.  zlib passes uncompressed files through unchanged */
+class Gz_source : public Trace_source
+{
+public:
+    Gz_source (gzFile file) { this->file = file; gzbuffer (file, 1 << 18); }
+    ~Gz_source () { gzclose (file); }
+
+    bool read_line (char *buf, int len) { return gzgets (file, buf, len) != NULL; }
+
+private:
+    gzFile file;
+};
+
+#ifdef HAVE_ZSTD
+class Zstd_source : public Trace_source
+{
+public:
+    Zstd_source (FILE *file)
+    {
+        this->file = file;
+        dctx = ZSTD_createDCtx ();
+        in_size = ZSTD_DStreamInSize ();
+        out_size = ZSTD_DStreamOutSize ();
+        in_buf = (char *) malloc (in_size);
+        out_buf = (char *) malloc (out_size);
+        in.src = in_buf;
+        in.size = 0;
+        in.pos = 0;
+        out_pos = 0;
+        out_len = 0;
+        eof = false;
+    }
+
+    ~Zstd_source ()
+    {
+        ZSTD_freeDCtx (dctx);
+        free (in_buf);
+        free (out_buf);
+        fclose (file);
+    }
+
+    bool read_line (char *buf, int len)
+    {
+        int n = 0;
+        while (n < len - 1) {
+            if (out_pos == out_len && !refill ())
+                break;
+            char c = out_buf[out_pos++];
+            buf[n++] = c;
+            if (c == '\n')
+                break;
+        }
+        buf[n] = '\0';
+        return n > 0;
+    }
+
+private:
+    FILE *file;
+    ZSTD_DCtx *dctx;
+    size_t in_size, out_size;
+    char *in_buf, *out_buf;
+    ZSTD_inBuffer in;
+    size_t out_pos, out_len;
+    bool eof;
+
+    /** Decompresses the next block into out_buf.  Returns false at the end */
+    bool refill (void)
+    {
+        out_pos = 0;
+        out_len = 0;
+        while (out_len == 0) {
+            if (in.pos == in.size) {
+                if (eof)
+                    return false;
+                in.size = fread (in_buf, 1, in_size, file);
+                in.pos = 0;
+                if (in.size == 0) {
+                    eof = true;
+                    return false;
+                }
+            }
+            ZSTD_outBuffer out = { out_buf, out_size, 0 };
+            if (ZSTD_isError (ZSTD_decompressStream (dctx, &out, &in)))
+                return false;
+            out_len = out.pos;
+        }
+        return true;
+    }
+};
+#endif
+
+static Trace_source *open_source (const char *path)
+{
+    unsigned char magic[4] = { 0, 0, 0, 0 };
+    FILE *f = fopen (path, "rb");
+    if (!f)
+        return NULL;
+    size_t n = fread (magic, 1, sizeof (magic), f);
+
+    if (n == 4 && magic[0] == 0x28 && magic[1] == 0xb5 && magic[2] == 0x2f && magic[3] == 0xfd) {
+#ifdef HAVE_ZSTD
+        rewind (f);
+        return new Zstd_source (f);
+#else
+        fprintf (stderr, "%s is zstd compressed, rebuild with -DHAVE_ZSTD\n", path);
+        fclose (f);
+        return NULL;
+#endif
+    }
+    fclose (f);
+
+    gzFile gz = gzopen (path, "rb");
+    if (!gz)
+        return NULL;
+    return new Gz_source (gz);
+}
+
+/*************************
+ * Trace_ring
+ *************************/
+Trace_ring::Trace_ring (unsigned int size_log2)
+{
+    size = 1ULL << size_log2;
+    mask = size - 1;
+    refs = new Trace_ref[size];
+    head = 0;
+    tail = 0;
+    done = false;
+}
+
+Trace_ring::~Trace_ring ()
+{
+    delete [] refs;
+}
+
+/*************************
+ * Compressed_trace
+ *************************/
+Compressed_trace::Compressed_trace ()
+{
+    num_streams = 0;
+    sources = NULL;
+    rings = NULL;
+    running = false;
+    stop = false;
+}
+
+Compressed_trace::~Compressed_trace ()
+{
+    close ();
+}
+
+bool Compressed_trace::open (unsigned int num_streams, char **paths, unsigned int ring_log2)
+{
+    this->num_streams = num_streams;
+    sources = new Trace_source *[num_streams];
+    rings = new Trace_ring *[num_streams];
+    for (unsigned int i = 0; i < num_streams; i++) {
+        sources[i] = NULL;
+        rings[i] = new Trace_ring (ring_log2);
+    }
+
+    for (unsigned int i = 0; i < num_streams; i++) {
+        sources[i] = open_source (paths[i]);
+        if (!sources[i]) {
+            fprintf (stderr, "Could not open trace %s\n", paths[i]);
+            close ();
+            return false;
+        }
+    }
+
+    stop = false;
+    if (pthread_create (&thread, NULL, Compressed_trace::read_ahead, this) != 0) {
+        close ();
+        return false;
+    }
+    running = true;
+    return true;
+}
+
+void Compressed_trace::close (void)
+{
+    if (running) {
+        stop = true;
+        pthread_join (thread, NULL);
+        running = false;
+    }
+    for (unsigned int i = 0; i < num_streams; i++) {
+        if (sources)
+            delete sources[i];
+        if (rings)
+            delete rings[i];
+    }
+    delete [] sources;
+    delete [] rings;
+    sources = NULL;
+    rings = NULL;
+    num_streams = 0;
+}
+
+void *Compressed_trace::read_ahead (void *arg)
+{
+    ((Compressed_trace *) arg)->fill ();
+    return NULL;
+}
+
+void Compressed_trace::fill (void)
+{
+    char line[256];
+    bool *finished = new bool[num_streams];
+    unsigned int remaining = num_streams;
+
+    for (unsigned int i = 0; i < num_streams; i++)
+        finished[i] = false;
+
+    while (remaining && !stop) {
+        bool progress = false;
+
+        for (unsigned int i = 0; i < num_streams; i++) {
+            if (finished[i])
+                continue;
+
+            for (int n = 0; n < FILL_BATCH && !rings[i]->full (); n++) {
+                if (!sources[i]->read_line (line, sizeof (line))) {
+                    rings[i]->finish ();
+                    finished[i] = true;
+                    remaining--;
+                    break;
+                }
+                Trace_ref ref;
+                if (parse_trace_line (line, &ref))
+                    rings[i]->push (ref);
+                progress = true;
+            }
+        }
+
+        /* Every ring is full, let the simulation catch up */
+        if (!progress)
+            sched_yield ();
+    }
+
+    delete [] finished;
+}
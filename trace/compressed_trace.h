@@ -0,0 +1,100 @@
+#ifndef COMPRESSED_TRACE_H_
+#define COMPRESSED_TRACE_H_
+
+#include <pthread.h>
+#include <sched.h>
+#include "binary_trace.h"
+
+class Trace_source;
+
+/** Single producer / single consumer ring of references.  The read-ahead
+ * thread is the only writer of tail and the simulation thread the only writer
+ * of head, so no locks are needed, only ordering barriers.
+ */
+class Trace_ring
+{
+public:
+    Trace_ring (unsigned int size_log2);
+    ~Trace_ring ();
+
+    inline bool full (void) { return tail - head == size; }
+
+    /** Producer side */
+    inline void push (const Trace_ref &ref)
+    {
+        refs[tail & mask] = ref;
+        __sync_synchronize ();
+        tail = tail + 1;
+    }
+
+    /** Producer side, after the last push */
+    inline void finish (void)
+    {
+        __sync_synchronize ();
+        done = true;
+    }
+
+    /** Consumer side.  Returns false once the stream is finished and drained;
+     * only spins if the read-ahead thread has fallen behind.
+     */
+    inline bool pop (Trace_ref *ref)
+    {
+        while (head == tail) {
+            if (done) {
+                __sync_synchronize ();
+                if (head == tail)
+                    return false;
+                break;
+            }
+            sched_yield ();
+        }
+        __sync_synchronize ();
+        *ref = refs[head & mask];
+        __sync_synchronize ();
+        head = head + 1;
+        return true;
+    }
+
+private:
+    Trace_ref *refs;
+    unsigned long long size;
+    unsigned long long mask;
+    volatile unsigned long long head;
+    volatile unsigned long long tail;
+    volatile bool done;
+};
+
+/** Reads gzip or zstd compressed (or plain) per-core text traces.
+ *
+ * A background thread decompresses and parses every stream and fills one
+ * Trace_ring per core, so the simulation thread never waits on I/O or
+ * decompression as long as the thread keeps ahead.  zstd support needs
+ * HAVE_ZSTD; gzip and uncompressed files always work.
+ */
+class Compressed_trace
+{
+public:
+    Compressed_trace ();
+    ~Compressed_trace ();
+
+    /** Opens one file per stream and starts the read-ahead thread */
+    bool open (unsigned int num_streams, char **paths, unsigned int ring_log2 = 16);
+    void close (void);
+
+    unsigned int get_num_streams (void) { return num_streams; }
+
+    inline bool next (unsigned int stream, Trace_ref *ref) { return rings[stream]->pop (ref); }
+
+private:
+    unsigned int num_streams;
+    Trace_source **sources;
+    Trace_ring **rings;
+    pthread_t thread;
+    bool running;
+    volatile bool stop;
+
+    static void *read_ahead (void *arg);
+    void fill (void);
+};
+
+#endif /* COMPRESSED_TRACE_H_ */
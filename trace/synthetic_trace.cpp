@@ -0,0 +1,124 @@
+#include <stdlib.h>
+#include "synthetic_trace.h"
+
+/** Word size used by the false sharing pattern */
+#define SYNTHETIC_WORD_SIZE 8
+
+Synthetic_trace::Synthetic_trace ()
+{
+    streams = NULL;
+    default_config (&config);
+}
+
+Synthetic_trace::~Synthetic_trace ()
+{
+    close ();
+}
+
+void Synthetic_trace::default_config (Synthetic_config *config)
+{
+    config->num_cores = 4;
+    config->refs_per_core = 1000000;
+    config->line_size = 64;
+    config->footprint_lines = 4096;
+    config->write_ratio = 0.3;
+    config->shared_fraction = 0;
+    config->sharing_degree = 2;
+    config->shared_lines = 1024;
+    config->migratory_fraction = 0;
+    config->migratory_lines = 64;
+    config->producer_consumer_fraction = 0;
+    config->producer_consumer_lines = 256;
+    config->false_sharing_fraction = 0;
+    config->false_sharing_lines = 16;
+    config->seed = 1;
+}
+
+bool Synthetic_trace::open (const Synthetic_config &config)
+{
+    close ();
+
+    double patterns = config.shared_fraction + config.migratory_fraction
+                      + config.producer_consumer_fraction + config.false_sharing_fraction;
+
+    if (config.num_cores == 0 || config.line_size < SYNTHETIC_WORD_SIZE)
+        return false;
+    if (config.write_ratio < 0 || config.write_ratio > 1 || patterns > 1)
+        return false;
+    if (config.shared_fraction < 0 || config.migratory_fraction < 0
+        || config.producer_consumer_fraction < 0 || config.false_sharing_fraction < 0)
+        return false;
+    /* Every pattern that gets references needs lines to put them on */
+    if ((patterns < 1 && config.footprint_lines == 0)
+        || (config.shared_fraction > 0 && config.shared_lines == 0)
+        || (config.migratory_fraction > 0 && config.migratory_lines == 0)
+        || (config.producer_consumer_fraction > 0 && config.producer_consumer_lines == 0)
+        || (config.false_sharing_fraction > 0 && config.false_sharing_lines == 0))
+        return false;
+
+    this->config = config;
+    if (this->config.sharing_degree == 0 || this->config.sharing_degree > config.num_cores)
+        this->config.sharing_degree = config.num_cores;
+
+    streams = new Stream[config.num_cores];
+    for (unsigned int i = 0; i < config.num_cores; i++) {
+        /* Zero would stay zero forever */
+        streams[i].rng = (config.seed + i + 1) * 0x9E3779B97F4A7C15ULL;
+        if (!streams[i].rng)
+            streams[i].rng = 1;
+        streams[i].count = 0;
+        streams[i].pending_write = false;
+        streams[i].pending_addr = 0;
+    }
+    return true;
+}
+
+void Synthetic_trace::close (void)
+{
+    delete [] streams;
+    streams = NULL;
+}
+
+/** The patterns use disjoint address ranges, laid out in this order: private
+ * footprints, shared groups, migratory, producer/consumer, false sharing
+ */
+void Synthetic_trace::generate (unsigned int stream, Stream &s, Trace_ref *ref)
+{
+    const Synthetic_config &c = config;
+    unsigned long long groups = (c.num_cores + c.sharing_degree - 1) / c.sharing_degree;
+    unsigned long long shared_base = c.num_cores * c.footprint_lines;
+    unsigned long long migratory_base = shared_base + groups * c.shared_lines;
+    unsigned long long pc_base = migratory_base + c.migratory_lines;
+    unsigned long long fs_base = pc_base + c.producer_consumer_lines;
+
+    double pick = uniform (s);
+    bool write = uniform (s) < c.write_ratio;
+    unsigned long long line;
+    paddr_t offset = 0;
+
+    if ((pick -= c.shared_fraction) < 0) {
+        line = shared_base + (stream / c.sharing_degree) * c.shared_lines
+               + next_random (s) % c.shared_lines;
+    } else if ((pick -= c.migratory_fraction) < 0) {
+        line = migratory_base + next_random (s) % c.migratory_lines;
+        write = false;
+        s.pending_write = true;
+        s.pending_addr = (paddr_t) line * c.line_size;
+    } else if ((pick -= c.producer_consumer_fraction) < 0) {
+        unsigned long long i = next_random (s) % c.producer_consumer_lines;
+        line = pc_base + i;
+        write = (i % c.num_cores) == stream;
+    } else if ((pick -= c.false_sharing_fraction) < 0) {
+        line = fs_base + next_random (s) % c.false_sharing_lines;
+        offset = (stream * SYNTHETIC_WORD_SIZE) % c.line_size;
+    } else {
+        line = stream * c.footprint_lines + next_random (s) % c.footprint_lines;
+    }
+
+    /* A pair can't be split across the end of the stream */
+    if (s.pending_write && s.count == c.refs_per_core)
+        s.pending_write = false;
+
+    ref->op = write ? 'w' : 'r';
+    ref->addr = (paddr_t) line * c.line_size + offset;
+}
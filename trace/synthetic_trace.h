@@ -0,0 +1,112 @@
+#ifndef SYNTHETIC_TRACE_H_
+#define SYNTHETIC_TRACE_H_
+
+#include "binary_trace.h"
+
+/** Shape of a generated workload.  The fractions pick which pattern each
+ * reference comes from; whatever they leave over goes to the core's private
+ * footprint.
+ */
+typedef struct {
+    unsigned int num_cores;
+    unsigned long long refs_per_core;
+    unsigned int line_size;
+    /** Private lines of each core */
+    unsigned long long footprint_lines;
+    /** Chance a private, shared or false shared reference is a write */
+    double write_ratio;
+
+    /** Lines read and written by groups of sharing_degree cores */
+    double shared_fraction;
+    unsigned int sharing_degree;
+    unsigned long long shared_lines;
+
+    /** Read-then-write pairs on lines every core takes turns on */
+    double migratory_fraction;
+    unsigned long long migratory_lines;
+
+    /** Lines each written by one core and read by the others */
+    double producer_consumer_fraction;
+    unsigned long long producer_consumer_lines;
+
+    /** Lines where every core writes its own word */
+    double false_sharing_fraction;
+    unsigned long long false_sharing_lines;
+
+    unsigned long long seed;
+} Synthetic_config;
+
+/** Generates references on the fly, with the same next () interface as
+ * Binary_trace and Compressed_trace, so a workload of any length can be fed
+ * to the simulator without writing it out first.
+ *
+ * Every stream has its own random number generator seeded from seed and the
+ * stream number, so a stream is the same no matter how the streams are
+ * interleaved, and the text or binary trace written by trace_gen replays
+ * exactly what the simulator would have been fed.
+ */
+class Synthetic_trace
+{
+public:
+    Synthetic_trace ();
+    ~Synthetic_trace ();
+
+    /** Fills config with a small private-only workload */
+    static void default_config (Synthetic_config *config);
+
+    /** Returns false if config doesn't describe a workload */
+    bool open (const Synthetic_config &config);
+    void close (void);
+
+    unsigned int get_num_streams (void) { return config.num_cores; }
+    unsigned long long get_count (unsigned int stream) { return config.refs_per_core; }
+
+    /** Generates the next reference of stream.  Returns false at the end of the stream */
+    inline bool next (unsigned int stream, Trace_ref *ref)
+    {
+        Stream &s = streams[stream];
+        if (s.count == config.refs_per_core)
+            return false;
+        s.count++;
+
+        /* Second half of a migratory read-modify-write */
+        if (s.pending_write) {
+            s.pending_write = false;
+            ref->op = 'w';
+            ref->addr = s.pending_addr;
+            return true;
+        }
+        generate (stream, s, ref);
+        return true;
+    }
+
+private:
+    struct Stream {
+        unsigned long long rng;
+        unsigned long long count;
+        bool pending_write;
+        paddr_t pending_addr;
+    };
+
+    Synthetic_config config;
+    Stream *streams;
+
+    /** xorshift64*, one per stream */
+    static inline unsigned long long next_random (Stream &s)
+    {
+        s.rng ^= s.rng >> 12;
+        s.rng ^= s.rng << 25;
+        s.rng ^= s.rng >> 27;
+        return s.rng * 0x2545F4914F6CDD1DULL;
+    }
+
+    /** Uniform in [0, 1) */
+    static inline double uniform (Stream &s)
+    {
+        return (next_random (s) >> 11) * (1.0 / 9007199254740992.0);
+    }
+
+    void generate (unsigned int stream, Stream &s, Trace_ref *ref);
+};
+
+#endif /* SYNTHETIC_TRACE_H_ */
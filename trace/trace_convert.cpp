@@ -0,0 +1,46 @@
+#include <stdlib.h>
+#include "binary_trace.h"
+
+/**
+ * Converts per-core text traces into one binary trace.
+ *
+ * usage: trace_convert <out.bin> <p0.trace> [p1.trace ...]
+ * Stream i of the output holds the references of the i-th input file.
+ */
+int main (int argc, char *argv[])
+{
+    if (argc < 3) {
+        fprintf (stderr, "usage: %s <out.bin> <p0.trace> [p1.trace ...]\n", argv[0]);
+        return 1;
+    }
+
+    unsigned int num_streams = argc - 2;
+    Binary_trace_writer writer;
+    if (!writer.open (argv[1], num_streams)) {
+        fprintf (stderr, "Could not open %s\n", argv[1]);
+        return 1;
+    }
+
+    char line[256];
+    for (unsigned int i = 0; i < num_streams; i++) {
+        FILE *in = fopen (argv[i + 2], "r");
+        if (!in) {
+            fprintf (stderr, "Could not open %s\n", argv[i + 2]);
+            return 1;
+        }
+
+        writer.begin_stream (i);
+        while (fgets (line, sizeof (line), in)) {
+            Trace_ref ref;
+            if (parse_trace_line (line, &ref))
+                writer.add (ref);
+        }
+        fclose (in);
+    }
+
+    if (!writer.close ()) {
+        fprintf (stderr, "Error writing %s\n", argv[1]);
+        return 1;
+    }
+    return 0;
+}
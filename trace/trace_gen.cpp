@@ -0,0 +1,117 @@
+#include <stdlib.h>
+#include <unistd.h>
+#include <string>
+#include "synthetic_trace.h"
+
+/**
+ * Writes a synthetic workload as per-core text traces or as one binary trace.
+ *
+ * usage: trace_gen [options] (-o <dir> | -b <out.bin>)
+ *     -c cores         -n references per core    -l line size
+ *     -f private lines per core                  -w write ratio
+ *     -s shared fraction   -d sharing degree     -S shared lines per group
+ *     -m migratory fraction                      -M migratory lines
+ *     -p producer/consumer fraction              -P producer/consumer lines
+ *     -x false sharing fraction                  -X false sharing lines
+ *     -r seed
+ *
+ * Text traces go to <dir>/p<core>.trace.  The same workload can be fed to the
+ * simulator directly through Synthetic_trace without writing anything out.
+ */
+static void usage (const char *name)
+{
+    fprintf (stderr, "usage: %s [-c cores] [-n refs] [-l line] [-f lines] [-w ratio] "
+             "[-s frac] [-d degree] [-S lines] [-m frac] [-M lines] [-p frac] [-P lines] "
+             "[-x frac] [-X lines] [-r seed] (-o dir | -b out.bin)\n", name);
+    exit (1);
+}
+
+static bool write_text (Synthetic_trace &trace, const std::string &dir)
+{
+    static char buffer[1 << 18];
+    Trace_ref ref;
+
+    for (unsigned int i = 0; i < trace.get_num_streams (); i++) {
+        char name[32];
+        sprintf (name, "/p%u.trace", i);
+        std::string path = dir + name;
+        FILE *out = fopen (path.c_str (), "w");
+        if (!out) {
+            fprintf (stderr, "Could not open %s\n", path.c_str ());
+            return false;
+        }
+        setvbuf (out, buffer, _IOFBF, sizeof (buffer));
+        while (trace.next (i, &ref))
+            fprintf (out, "%c 0x%llx\n", ref.op, (unsigned long long) ref.addr);
+        if (fclose (out) != 0) {
+            fprintf (stderr, "Error writing %s\n", path.c_str ());
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool write_binary (Synthetic_trace &trace, const char *path)
+{
+    Binary_trace_writer writer;
+    Trace_ref ref;
+
+    if (!writer.open (path, trace.get_num_streams ())) {
+        fprintf (stderr, "Could not open %s\n", path);
+        return false;
+    }
+    for (unsigned int i = 0; i < trace.get_num_streams (); i++) {
+        writer.begin_stream (i);
+        while (trace.next (i, &ref))
+            writer.add (ref);
+    }
+    if (!writer.close ()) {
+        fprintf (stderr, "Error writing %s\n", path);
+        return false;
+    }
+    return true;
+}
+
+int main (int argc, char *argv[])
+{
+    Synthetic_config config;
+    const char *dir = NULL;
+    const char *binary = NULL;
+    int opt;
+
+    Synthetic_trace::default_config (&config);
+    while ((opt = getopt (argc, argv, "c:n:l:f:w:s:d:S:m:M:p:P:x:X:r:o:b:")) != -1) {
+        switch (opt) {
+        case 'c': config.num_cores = atoi (optarg); break;
+        case 'n': config.refs_per_core = strtoull (optarg, NULL, 0); break;
+        case 'l': config.line_size = atoi (optarg); break;
+        case 'f': config.footprint_lines = strtoull (optarg, NULL, 0); break;
+        case 'w': config.write_ratio = atof (optarg); break;
+        case 's': config.shared_fraction = atof (optarg); break;
+        case 'd': config.sharing_degree = atoi (optarg); break;
+        case 'S': config.shared_lines = strtoull (optarg, NULL, 0); break;
+        case 'm': config.migratory_fraction = atof (optarg); break;
+        case 'M': config.migratory_lines = strtoull (optarg, NULL, 0); break;
+        case 'p': config.producer_consumer_fraction = atof (optarg); break;
+        case 'P': config.producer_consumer_lines = strtoull (optarg, NULL, 0); break;
+        case 'x': config.false_sharing_fraction = atof (optarg); break;
+        case 'X': config.false_sharing_lines = strtoull (optarg, NULL, 0); break;
+        case 'r': config.seed = strtoull (optarg, NULL, 0); break;
+        case 'o': dir = optarg; break;
+        case 'b': binary = optarg; break;
+        default: usage (argv[0]);
+        }
+    }
+    if (optind != argc || (!dir == !binary))
+        usage (argv[0]);
+
+    Synthetic_trace trace;
+    if (!trace.open (config)) {
+        fprintf (stderr, "Invalid workload: the fractions must add up to at most 1 "
+                 "and every pattern in use needs lines\n");
+        return 1;
+    }
+
+    bool ok = dir ? write_text (trace, dir) : write_binary (trace, binary);
+    return ok ? 0 : 1;
+}